@@ -0,0 +1,48 @@
+#include "lunaris/core/job_system.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace lunaris;
+
+static double measure_jobs_per_second(uint32_t workers, uint32_t jobs) {
+    JobSystem system;
+    system.init(workers);
+    std::atomic<uint32_t> remaining(jobs);
+
+    auto start = std::chrono::steady_clock::now();
+    system.submit_lambda([&system, &remaining, jobs]() {
+        for (uint32_t i = 0; i < jobs; ++i) {
+            system.submit_lambda([&remaining, i]() {
+                volatile uint32_t x = i;
+                for (uint32_t k = 0; k < 256; ++k) {
+                    x = x * 1664525u + 1013904223u;
+                }
+                remaining.fetch_sub(1, std::memory_order_release);
+            }, "BenchmarkJob");
+        }
+    }, "BenchmarkSpawn");
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    system.shutdown();
+    return seconds > 0.0 ? jobs / seconds : 0.0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t jobs = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 1000000;
+    if (jobs == 0) {
+        fprintf(stderr, "usage: %s [jobs]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t hardware = std::thread::hardware_concurrency();
+    for (uint32_t workers = 1; workers <= hardware && workers <= JobSystem::MAX_WORKERS; workers *= 2) {
+        printf("%u workers: %.2fM jobs/s\n", workers, measure_jobs_per_second(workers, jobs) / 1000000.0);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "lunaris/editor/newline_scan.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace lunaris;
+
+using CountFunc = size_t(*)(const char*, size_t);
+
+static double measure_gbps(CountFunc func, const char* data, size_t len, size_t expected) {
+    auto start = std::chrono::steady_clock::now();
+    size_t count = func(data, len);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    if (count != expected || seconds <= 0.0) {
+        return 0.0;
+    }
+    return static_cast<double>(len) / seconds / 1e9;
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+    size_t bytes = megabytes * 1024 * 1024;
+    if (bytes == 0) {
+        fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+        return 1;
+    }
+
+    char* data = new char[bytes];
+    uint32_t seed = 0x12345678u;
+    size_t expected = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        char c = static_cast<char>('a' + (seed >> 24) % 26);
+        if ((seed >> 8) % 80 == 0) {
+            c = '\n';
+            ++expected;
+        }
+        data[i] = c;
+    }
+
+    double scalar_gbps = measure_gbps(text::count_newlines_scalar, data, bytes, expected);
+    double simd_gbps = measure_gbps(text::count_newlines, data, bytes, expected);
+    delete[] data;
+
+    printf("newline scan over %zu MB: scalar %.2f GB/s, %s %.2f GB/s\n",
+        megabytes, scalar_gbps, text::get_newline_scan_isa(), simd_gbps);
+    return scalar_gbps > 0.0 && simd_gbps > 0.0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "lunaris/core/job_system.h"
+#include <coroutine>
+#include <cstddef>
+
+namespace lunaris {
+
+struct FileReadResult {
+    char* data;
+    size_t length;
+};
+
+char* read_whole_file(const char* path, size_t& out_length);
+bool write_whole_file(const char* path, const char* data, size_t length);
+
+class FileReadAwaiter {
+public:
+    static constexpr size_t MAX_PATH_LEN = 1024;
+
+    FileReadAwaiter(JobSystem* jobs, const char* path, JobTarget resume_target);
+
+    bool await_ready() const noexcept { return _path[0] == '\0'; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    FileReadResult await_resume() const { return _result; }
+
+private:
+    JobSystem* _jobs;
+    JobTarget _target;
+    FileReadResult _result;
+    char _path[MAX_PATH_LEN];
+};
+
+class FileWriteAwaiter {
+public:
+    static constexpr size_t MAX_PATH_LEN = 1024;
+
+    FileWriteAwaiter(JobSystem* jobs, const char* path, const char* data, size_t length, JobTarget resume_target);
+
+    bool await_ready() const noexcept { return _path[0] == '\0'; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    bool await_resume() const { return _ok; }
+
+private:
+    JobSystem* _jobs;
+    JobTarget _target;
+    const char* _data;
+    size_t _length;
+    bool _ok;
+    char _path[MAX_PATH_LEN];
+};
+
+inline FileReadAwaiter read_file_async(JobSystem* jobs, const char* path, JobTarget resume_target = JobTarget::Worker) {
+    return FileReadAwaiter(jobs, path, resume_target);
+}
+
+inline FileWriteAwaiter write_file_async(JobSystem* jobs, const char* path, const char* data, size_t length,
+                                         JobTarget resume_target = JobTarget::Worker) {
+    return FileWriteAwaiter(jobs, path, data, length, resume_target);
+}
+
+}
@@ -5,7 +5,7 @@
 
 namespace lunaris {
 
-using JobID = uint32_t;
+using JobID = uint64_t;
 constexpr JobID INVALID_JOB_ID = 0;
 
 enum class JobPriority : uint8_t {
@@ -15,6 +15,12 @@ enum class JobPriority : uint8_t {
     Critical = 3
 };
 
+enum class JobTarget : uint8_t {
+    Worker,
+    MainThread,
+    Io
+};
+
 enum class JobState : uint8_t {
     Pending,
     Running,
@@ -23,11 +29,36 @@ enum class JobState : uint8_t {
     Cancelled
 };
 
+class CancelToken {
+public:
+    CancelToken() : _source(nullptr), _generation(0) {}
+    CancelToken(const std::atomic<uint32_t>* source, uint32_t generation) : _source(source), _generation(generation) {}
+
+    bool is_cancelled() const { return _source && _source->load(std::memory_order_acquire) != _generation; }
+
+private:
+    const std::atomic<uint32_t>* _source;
+    uint32_t _generation;
+};
+
+class CancelSource {
+public:
+    CancelSource() : _generation(0) {}
+
+    CancelToken get_token() const { return CancelToken(&_generation, _generation.load(std::memory_order_acquire)); }
+    CancelToken supersede() { return CancelToken(&_generation, _generation.fetch_add(1, std::memory_order_acq_rel) + 1); }
+    void cancel() { _generation.fetch_add(1, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<uint32_t> _generation;
+};
+
 class Job {
 public:
     Job() 
         : _id(INVALID_JOB_ID)
         , _priority(JobPriority::Normal)
+        , _target(JobTarget::Worker)
         , _state(JobState::Pending) {}
     
     virtual ~Job() = default;
@@ -37,9 +68,14 @@ public:
 
     JobID get_id() const { return _id; }
     JobPriority get_priority() const { return _priority; }
+    JobTarget get_target() const { return _target; }
     JobState get_state() const { return _state.load(); }
+    const CancelToken& get_cancel_token() const { return _token; }
+    bool is_cancelled() const { return _token.is_cancelled(); }
 
     void set_priority(JobPriority priority) { _priority = priority; }
+    void set_target(JobTarget target) { _target = target; }
+    void set_cancel_token(const CancelToken& token) { _token = token; }
 
     bool is_complete() const { 
         JobState s = _state.load();
@@ -55,7 +91,9 @@ private:
     void set_id(JobID id) { _id = id; }
 
     JobID _id;
+    CancelToken _token;
     JobPriority _priority;
+    JobTarget _target;
     std::atomic<JobState> _state;
 };
 
@@ -1,60 +1,369 @@
 #pragma once
 
 #include "lunaris/core/job.h"
+#include "lunaris/core/work_queue.h"
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <chrono>
+#include <new>
 
 namespace lunaris {
 
+struct alignas(64) JobSlot {
+    static constexpr size_t STORAGE_SIZE = 128;
+    static constexpr size_t STORAGE_ALIGN = 16;
+    static constexpr uint32_t MAX_DEPENDENCIES = 4;
+    static constexpr uint32_t CLOSED_LINK = 0xFFFFFFFFu;
+
+    alignas(STORAGE_ALIGN) unsigned char storage[STORAGE_SIZE];
+    Job* job;
+    std::atomic<uint64_t> continuations;
+    std::atomic<uint32_t> generation;
+    std::atomic<uint32_t> next;
+    std::atomic<uint32_t> dependencies;
+    uint32_t links[MAX_DEPENDENCIES];
+    uint32_t timer_rounds;
+    uint64_t ready_ns;
+    bool pooled;
+};
+
+struct alignas(64) JobLaneStats {
+    std::atomic<uint64_t> busy_ns;
+    std::atomic<uint64_t> wait_ns;
+    std::atomic<uint64_t> jobs;
+};
+
+struct JobEvent {
+    std::atomic<uint64_t> sequence;
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> ready_ns;
+    std::atomic<uint64_t> start_ns;
+    std::atomic<uint64_t> end_ns;
+    std::atomic<uint32_t> lane;
+    std::atomic<uint32_t> queued;
+};
+
+struct JobLaneProfile {
+    uint64_t busy_ns;
+    uint64_t wait_ns;
+    uint64_t jobs;
+};
+
+struct JobProfile;
+
+struct Throttle {
+    Throttle() : last_ms(-1) {}
+
+    CancelSource source;
+    int64_t last_ms;
+};
+
 class JobSystem {
 public:
-    static constexpr uint32_t MAX_PENDING_JOBS = 1024;
     static constexpr uint32_t MAX_WORKERS = 16;
+    static constexpr uint32_t MAX_IO_WORKERS = 16;
+    static constexpr uint32_t DEFAULT_IO_WORKERS = 4;
+    static constexpr uint32_t PRIORITY_COUNT = 4;
+    static constexpr uint32_t SLOT_PAGE_SIZE = 4096;
+    static constexpr uint32_t MAX_SLOT_PAGES = 16384;
+    static constexpr uint32_t SLOT_CACHE_SIZE = 64;
+    static constexpr uint32_t MAX_RANGE_SPLITS = 32;
+    static constexpr uint32_t MAX_LANES = MAX_WORKERS + MAX_IO_WORKERS + 1;
+    static constexpr uint32_t EVENT_LOG_SIZE = 65536;
+    static constexpr uint32_t TIMER_TICK_MS = 1;
+    static constexpr uint32_t TIMER_WHEEL_BITS = 8;
+    static constexpr uint32_t TIMER_WHEEL_SIZE = 1u << TIMER_WHEEL_BITS;
+    static constexpr uint32_t MAX_DEPENDENCY_SCAN = 65536;
+    static constexpr uint32_t MAX_DEPENDENCY_STACK = 1024;
 
     JobSystem();
     ~JobSystem();
 
-    void init(uint32_t worker_count = 0);
+    void init(uint32_t worker_count = 0, uint32_t io_worker_count = 0);
     void shutdown();
 
     JobID submit(Job* job);
+    JobID submit_after(const JobID* dependencies, uint32_t count, Job* job);
+    JobID when_all(const JobID* ids, uint32_t count);
 
     template<typename Func>
-    JobID submit_lambda(Func&& func, const char* name = "LambdaJob", JobPriority priority = JobPriority::Normal) {
-        auto* job = new LambdaJob<Func>(static_cast<Func&&>(func), name);
-        job->set_priority(priority);
-        return submit(job);
+    JobID submit_lambda(Func&& func, const char* name = "LambdaJob", JobPriority priority = JobPriority::Normal,
+                        const CancelToken& token = CancelToken()) {
+        return submit_lambda_after(nullptr, 0, static_cast<Func&&>(func), name, priority, JobTarget::Worker, token);
+    }
+
+    template<typename Func>
+    JobID submit_io(Func&& func, const char* name = "IoJob", JobPriority priority = JobPriority::Normal,
+                    const CancelToken& token = CancelToken()) {
+        return submit_lambda_after(nullptr, 0, static_cast<Func&&>(func), name, priority, JobTarget::Io, token);
+    }
+
+    template<typename Func>
+    JobID then(JobID predecessor, Func&& func, const char* name = "LambdaJob", JobPriority priority = JobPriority::Normal,
+               const CancelToken& token = CancelToken()) {
+        return submit_lambda_after(&predecessor, 1, static_cast<Func&&>(func), name, priority, JobTarget::Worker, token);
+    }
+
+    template<typename Func>
+    JobID post_to_main_thread(Func&& func, const char* name = "MainThreadJob", const CancelToken& token = CancelToken()) {
+        return submit_lambda_after(nullptr, 0, static_cast<Func&&>(func), name, JobPriority::Normal, JobTarget::MainThread, token);
+    }
+
+    template<typename Func>
+    JobID then_on_main_thread(JobID predecessor, Func&& func, const char* name = "MainThreadJob", const CancelToken& token = CancelToken()) {
+        return submit_lambda_after(&predecessor, 1, static_cast<Func&&>(func), name, JobPriority::Normal, JobTarget::MainThread, token);
+    }
+
+    template<typename Func>
+    JobID submit_lambda_after(const JobID* dependencies, uint32_t count, Func&& func, const char* name = "LambdaJob",
+                              JobPriority priority = JobPriority::Normal, JobTarget target = JobTarget::Worker,
+                              const CancelToken& token = CancelToken()) {
+        if (!_running.load()) {
+            return INVALID_JOB_ID;
+        }
+
+        JobID joined = INVALID_JOB_ID;
+        if (count > JobSlot::MAX_DEPENDENCIES) {
+            joined = when_all(dependencies, count);
+            dependencies = &joined;
+            count = 1;
+        }
+
+        uint32_t index = 0;
+        Job* job = create_lambda(static_cast<Func&&>(func), name, priority, target, token, index);
+        return enqueue(index, job, dependencies, count, 0);
+    }
+
+    template<typename Func>
+    JobID submit_delayed(uint32_t delay_ms, Func&& func, const char* name = "DelayedJob", JobPriority priority = JobPriority::Normal,
+                         JobTarget target = JobTarget::Worker, const CancelToken& token = CancelToken()) {
+        if (!_running.load()) {
+            return INVALID_JOB_ID;
+        }
+
+        uint32_t index = 0;
+        Job* job = create_lambda(static_cast<Func&&>(func), name, priority, target, token, index);
+        return enqueue(index, job, nullptr, 0, delay_ms);
+    }
+
+    template<typename Func>
+    JobID debounce(CancelSource& key, uint32_t delay_ms, Func&& func, const char* name = "DebouncedJob",
+                   JobPriority priority = JobPriority::Normal, JobTarget target = JobTarget::Worker) {
+        return submit_delayed(delay_ms, static_cast<Func&&>(func), name, priority, target, key.supersede());
+    }
+
+    template<typename Func>
+    JobID throttle(Throttle& state, uint32_t interval_ms, Func&& func, const char* name = "ThrottledJob",
+                   JobPriority priority = JobPriority::Normal, JobTarget target = JobTarget::Worker) {
+        uint32_t delay_ms = 0;
+        CancelToken token = throttle_window(state, interval_ms, delay_ms);
+        return submit_delayed(delay_ms, static_cast<Func&&>(func), name, priority, target, token);
+    }
+
+    template<typename Func>
+    void parallel_for(size_t begin, size_t end, size_t grain, const Func& func, JobPriority priority = JobPriority::Normal) {
+        run_range(begin, end, grain > 0 ? grain : 1, &func, priority);
+    }
+
+    template<typename T, typename Map, typename Combine>
+    T parallel_reduce(size_t begin, size_t end, size_t grain, const T& identity, const Map& map, const Combine& combine,
+                      JobPriority priority = JobPriority::Normal) {
+        return reduce_range(begin, end, grain > 0 ? grain : 1, identity, &map, &combine, priority);
     }
 
     void wait(JobID id);
     void wait_all();
+    uint32_t drain_main_thread(float budget_ms);
 
     bool is_complete(JobID id) const;
-    uint32_t get_pending_count() const;
+    uint32_t get_pending_count() const { return _queued.load(std::memory_order_acquire) + _io_queued.load(std::memory_order_acquire); }
     uint32_t get_worker_count() const { return _worker_count; }
+    uint32_t get_io_worker_count() const { return _io_worker_count; }
 
-private:
-    void worker_thread(uint32_t worker_id);
-    Job* pop_job();
-    Job* find_job(JobID id) const;
-    JobID generate_id();
+    void set_profiling(bool enabled);
+    bool is_profiling() const { return _profiling.load(std::memory_order_acquire); }
+    JobProfile get_profile() const;
+    bool export_chrome_trace(const char* path, uint32_t& event_count) const;
 
-    struct JobEntry {
-        Job* job;
-        bool owns_memory;
+private:
+    struct Worker {
+        WorkDeque deques[PRIORITY_COUNT];
+        std::thread* thread;
+        uint32_t seed;
+        uint32_t free_count;
+        uint32_t free_slots[SLOT_CACHE_SIZE];
     };
 
-    JobEntry _pending_jobs[MAX_PENDING_JOBS];
-    uint32_t _pending_count;
-    mutable std::mutex _queue_mutex;
-    std::condition_variable _queue_cv;
+    template<typename Func>
+    void run_range(size_t begin, size_t end, size_t grain, const Func* func, JobPriority priority) {
+        JobID children[MAX_RANGE_SPLITS];
+        uint32_t count = 0;
+        while (begin < end) {
+            if (end - begin > grain && count < MAX_RANGE_SPLITS && should_split()) {
+                size_t mid = begin + (end - begin) / 2;
+                JobID id = submit_lambda([this, mid, end, grain, func, priority]() {
+                    run_range(mid, end, grain, func, priority);
+                }, "ParallelFor", priority);
+                if (id != INVALID_JOB_ID) {
+                    children[count++] = id;
+                    end = mid;
+                    continue;
+                }
+            }
+            size_t stop = end - begin > grain ? begin + grain : end;
+            (*func)(begin, stop);
+            begin = stop;
+        }
+        for (uint32_t i = count; i > 0; --i) {
+            wait(children[i - 1]);
+        }
+    }
+
+    template<typename T, typename Map, typename Combine>
+    T reduce_range(size_t begin, size_t end, size_t grain, const T& identity, const Map* map, const Combine* combine, JobPriority priority) {
+        JobID children[MAX_RANGE_SPLITS];
+        alignas(T) unsigned char storage[sizeof(T) * MAX_RANGE_SPLITS];
+        T* partials = reinterpret_cast<T*>(storage);
+        uint32_t count = 0;
+        T result = identity;
+        while (begin < end) {
+            if (end - begin > grain && count < MAX_RANGE_SPLITS && should_split()) {
+                size_t mid = begin + (end - begin) / 2;
+                T* partial = new (&partials[count]) T(identity);
+                JobID id = submit_lambda([this, mid, end, grain, &identity, map, combine, partial, priority]() {
+                    *partial = reduce_range(mid, end, grain, identity, map, combine, priority);
+                }, "ParallelReduce", priority);
+                if (id != INVALID_JOB_ID) {
+                    children[count++] = id;
+                    end = mid;
+                    continue;
+                }
+                partial->~T();
+            }
+            size_t stop = end - begin > grain ? begin + grain : end;
+            result = (*combine)(result, (*map)(begin, stop));
+            begin = stop;
+        }
+        for (uint32_t i = count; i > 0; --i) {
+            wait(children[i - 1]);
+            result = (*combine)(result, partials[i - 1]);
+            partials[i - 1].~T();
+        }
+        return result;
+    }
+
+    template<typename Func>
+    Job* create_lambda(Func&& func, const char* name, JobPriority priority, JobTarget target, const CancelToken& token, uint32_t& index) {
+        index = claim_slot();
+        JobSlot& slot = slot_at(index);
+        Job* job = nullptr;
+        if constexpr (sizeof(LambdaJob<Func>) <= JobSlot::STORAGE_SIZE && alignof(LambdaJob<Func>) <= JobSlot::STORAGE_ALIGN) {
+            job = new (slot.storage) LambdaJob<Func>(static_cast<Func&&>(func), name);
+            slot.pooled = true;
+        } else {
+            job = new LambdaJob<Func>(static_cast<Func&&>(func), name);
+            slot.pooled = false;
+        }
+        job->set_priority(priority);
+        job->set_target(target);
+        job->set_cancel_token(token);
+        return job;
+    }
+
+    bool should_split() const { return _queued.load(std::memory_order_relaxed) < _worker_count; }
+    void worker_thread(uint32_t worker_id);
+    void io_thread(uint32_t io_id);
+    void timer_thread();
+    uint32_t current_worker() const;
+    bool is_main_thread() const;
+    void wait_on_main_thread(JobID id);
+    void wait_all_on_main_thread();
+    bool take_main_dependency(uint32_t target, uint32_t& slot);
+    bool leads_to(uint32_t index, uint32_t target) const;
+    void collect_main_posted();
+    void wake_main_thread();
+    bool find_job(uint32_t worker_id, uint32_t& slot);
+    JobID enqueue(uint32_t index, Job* job, const JobID* dependencies, uint32_t count, uint32_t delay_ms);
+    bool add_continuation(JobID predecessor, uint32_t successor, uint32_t link);
+    void release_dependency(uint32_t index);
+    void schedule(uint32_t index);
+    void post_main(uint32_t index);
+    void run_job(uint32_t index);
+    void finish_job(uint32_t index, JobState state);
+    void sleep_until_work();
+    void wake_one();
+    void wake_io();
+    void add_timer(uint32_t index, uint32_t delay_ms);
+    void fire_timer(uint32_t index);
+    void advance_timers(uint64_t now);
+    uint64_t timer_now_ms() const;
+    uint64_t now_ns() const;
+    uint32_t current_lane() const;
+    void record_event(const char* name, uint64_t ready_ns, uint64_t start_ns, uint64_t end_ns, uint64_t nested_ns);
+    CancelToken throttle_window(Throttle& throttle, uint32_t interval_ms, uint32_t& delay_ms);
+
+    JobSlot& slot_at(uint32_t index) const { return _slot_pages[index / SLOT_PAGE_SIZE][index % SLOT_PAGE_SIZE]; }
+    uint32_t claim_slot();
+    void recycle_slot(uint32_t index);
+    bool acquire_slot(uint32_t& index);
+    void release_slot(uint32_t index);
+    void add_slot_page();
 
-    std::thread* _workers[MAX_WORKERS];
+    Worker* _workers;
     uint32_t _worker_count;
+    InjectionQueue _injected[PRIORITY_COUNT];
+
+    std::thread* _io_threads[MAX_IO_WORKERS];
+    uint32_t _io_worker_count;
+    InjectionQueue _io_queue;
+    std::atomic<uint32_t> _io_queued;
+    std::atomic<uint32_t> _io_sleepers;
+    std::mutex _io_mutex;
+    std::condition_variable _io_cv;
+
+    std::thread* _timer_thread;
+    uint32_t _timer_wheel[TIMER_WHEEL_SIZE];
+    uint64_t _timer_tick;
+    uint64_t _timer_next;
+    uint32_t _timer_count;
+    std::mutex _timer_mutex;
+    std::condition_variable _timer_cv;
+
+    std::chrono::steady_clock::time_point _epoch;
+    std::atomic<bool> _profiling;
+    uint64_t _profile_start_ns;
+    JobEvent* _events;
+    std::atomic<uint64_t> _event_head;
+    uint64_t _event_first;
+    JobLaneStats _lane_stats[MAX_LANES];
+
+    JobSlot* _slot_pages[MAX_SLOT_PAGES];
+    std::atomic<uint32_t> _slot_page_count;
+    std::atomic<uint64_t> _free_slots;
+    std::mutex _grow_mutex;
+
+    std::atomic<uint32_t> _main_posted;
+    uint32_t _main_head;
+    uint32_t _main_tail;
+    std::atomic<uint32_t> _main_wake;
+    std::atomic<uint32_t> _main_waiters;
+
+    std::atomic<uint32_t> _queued;
+    std::atomic<uint32_t> _active;
+    std::atomic<uint32_t> _active_waiters;
+    std::atomic<uint32_t> _sleepers;
+    std::mutex _sleep_mutex;
+    std::condition_variable _wake_cv;
 
     std::atomic<bool> _running;
-    std::atomic<JobID> _next_id;
+};
+
+struct JobProfile {
+    uint32_t worker_count;
+    uint32_t io_worker_count;
+    uint64_t elapsed_ns;
+    JobLaneProfile lanes[JobSystem::MAX_LANES];
 };
 
 }
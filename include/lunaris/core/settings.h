@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace lunaris {
 
 class Settings {
@@ -8,6 +10,10 @@ public:
     static constexpr float MAX_UI_SCALE = 2.0f;
     static constexpr float DEFAULT_UI_SCALE = 1.0f;
     static constexpr float SCALE_STEP = 0.1f;
+    static constexpr size_t MIN_UNDO_BUDGET = 1024 * 1024;
+    static constexpr size_t DEFAULT_UNDO_BUDGET = 64 * 1024 * 1024;
+    static constexpr float MIN_MAIN_THREAD_BUDGET_MS = 0.1f;
+    static constexpr float DEFAULT_MAIN_THREAD_BUDGET_MS = 2.0f;
 
     static Settings* get();
 
@@ -18,6 +24,12 @@ public:
     void zoom_out();
     void reset_zoom();
 
+    size_t get_undo_budget() const { return _undo_budget; }
+    void set_undo_budget(size_t bytes);
+
+    float get_main_thread_budget_ms() const { return _main_thread_budget_ms; }
+    void set_main_thread_budget_ms(float budget_ms);
+
     void apply();
 
 private:
@@ -25,6 +37,8 @@ private:
     ~Settings();
 
     float _ui_scale;
+    size_t _undo_budget;
+    float _main_thread_budget_ms;
 
     static Settings* _instance;
 };
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "lunaris/core/job_system.h"
+#include <coroutine>
+
+namespace lunaris {
+
+class Task {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        promise_type() : continuation(nullptr), detached(false) {}
+
+        Task get_return_object() { return Task(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return std::suspend_always(); }
+        FinalAwaiter final_suspend() const noexcept { return FinalAwaiter(); }
+        void return_void() {}
+        void unhandled_exception();
+
+        std::coroutine_handle<> continuation;
+        bool detached;
+    };
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task();
+
+    void start();
+    bool is_done() const { return !_handle || _handle.done(); }
+
+    bool await_ready() const noexcept { return is_done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept;
+    void await_resume() const noexcept {}
+
+private:
+    explicit Task(Handle handle) : _handle(handle) {}
+
+    Handle _handle;
+};
+
+class ResumeOn {
+public:
+    ResumeOn(JobSystem* jobs, JobTarget target, JobPriority priority = JobPriority::Normal)
+        : _jobs(jobs)
+        , _target(target)
+        , _priority(priority) {
+    }
+
+    bool await_ready() const noexcept { return !_jobs; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+
+private:
+    JobSystem* _jobs;
+    JobTarget _target;
+    JobPriority _priority;
+};
+
+class JobAwaiter {
+public:
+    JobAwaiter(JobSystem* jobs, JobID id, JobTarget target = JobTarget::Worker)
+        : _jobs(jobs)
+        , _id(id)
+        , _target(target) {
+    }
+
+    bool await_ready() const noexcept { return !_jobs; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+
+private:
+    JobSystem* _jobs;
+    JobID _id;
+    JobTarget _target;
+};
+
+}
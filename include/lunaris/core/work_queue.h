@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+namespace lunaris {
+
+struct WorkRing {
+    std::atomic<uint32_t>* items;
+    int64_t mask;
+    WorkRing* retired;
+};
+
+class WorkDeque {
+public:
+    static constexpr int64_t INITIAL_CAPACITY = 256;
+
+    WorkDeque();
+    ~WorkDeque();
+
+    void push(uint32_t item);
+    bool pop(uint32_t& item);
+    bool steal(uint32_t& item);
+
+private:
+    WorkRing* grow(WorkRing* ring, int64_t top, int64_t bottom);
+
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    std::atomic<WorkRing*> _ring;
+};
+
+class InjectionQueue {
+public:
+    static constexpr uint32_t INITIAL_CAPACITY = 256;
+
+    InjectionQueue();
+    ~InjectionQueue();
+
+    void push(uint32_t item);
+    bool pop(uint32_t& item);
+
+private:
+    std::mutex _mutex;
+    uint32_t* _items;
+    uint32_t _head;
+    uint32_t _count;
+    uint32_t _capacity;
+    std::atomic<uint32_t> _size;
+};
+
+}
@@ -6,6 +6,7 @@ namespace lunaris {
 
 class CommandRegistry;
 class Theme;
+class TextEditor;
 
 class CommandPalette {
 public:
@@ -19,8 +20,10 @@ public:
 
     void set_command_registry(CommandRegistry* registry) { _registry = registry; }
     void set_theme(Theme* theme) { _theme = theme; }
+    void set_text_editor(TextEditor* editor) { _text_editor = editor; }
 
     void open();
+    void open_with(const char* text);
     void close();
     void toggle();
 
@@ -33,9 +36,11 @@ private:
     void draw_input();
     void draw_results();
     void execute_selected();
+    bool is_line_query() const { return _search_buffer[0] == ':'; }
 
     CommandRegistry* _registry;
     Theme* _theme;
+    TextEditor* _text_editor;
 
     bool _is_open;
     bool _focus_input;
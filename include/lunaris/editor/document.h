@@ -2,6 +2,7 @@
 
 #include "lunaris/editor/text_buffer.h"
 #include "lunaris/editor/tab_bar.h"
+#include "lunaris/editor/path_table.h"
 #include <cstdint>
 
 namespace lunaris {
@@ -32,7 +33,8 @@ public:
     Document();
     ~Document();
 
-    bool open(const char* filepath);
+    bool open(const char* filepath, JobSystem* jobs = nullptr);
+    bool reload(JobSystem* jobs = nullptr);
     bool save();
     bool save_as(const char* filepath);
     void close();
@@ -45,6 +47,9 @@ public:
     TabID get_tab_id() const { return _tab_id; }
     void set_tab_id(TabID id) { _tab_id = id; }
 
+    PathID get_path_id() const { return _path_id; }
+    void set_path_id(PathID id) { _path_id = id; }
+
     const char* get_filepath() const { return _filepath; }
     const char* get_title() const { return _title; }
     bool has_file() const { return _filepath[0] != '\0'; }
@@ -76,6 +81,7 @@ private:
 
     DocumentID _id;
     TabID _tab_id;
+    PathID _path_id;
     char _filepath[MAX_PATH_LENGTH];
     char _title[MAX_TITLE_LENGTH];
     TextBuffer _buffer;
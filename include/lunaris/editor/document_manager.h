@@ -1,12 +1,15 @@
 #pragma once
 
 #include "lunaris/editor/document.h"
+#include "lunaris/editor/path_table.h"
+#include "lunaris/editor/undo_store.h"
 #include <cstdint>
 
 namespace lunaris {
 
 class TabBar;
 class Theme;
+class JobSystem;
 
 class DocumentManager {
 public:
@@ -17,6 +20,11 @@ public:
 
     void set_tab_bar(TabBar* tab_bar) { _tab_bar = tab_bar; }
     void set_theme(Theme* theme) { _theme = theme; }
+    void set_job_system(JobSystem* jobs) { _job_system = jobs; _undo_store.set_job_system(jobs); }
+    void set_workspace(const char* root) { _undo_store.set_workspace(root); }
+
+    PathTable& get_paths() { return _paths; }
+    const PathTable& get_paths() const { return _paths; }
 
     DocumentID new_document();
     DocumentID open_document(const char* filepath);
@@ -32,6 +40,7 @@ public:
     Document* get_active_document();
     const Document* get_active_document() const;
 
+    Document* get_document_at(uint32_t index) { return _documents[index]; }
     Document* get_document(DocumentID id);
     const Document* get_document(DocumentID id) const;
     Document* find_by_path(const char* filepath);
@@ -40,6 +49,9 @@ public:
     uint32_t get_document_count() const { return _document_count; }
     bool has_unsaved_changes() const;
 
+    uint32_t poll_file_changes();
+    bool poll_indexing(float& progress);
+
     void on_tab_selected(TabID tab_id);
     void on_tab_closed(TabID tab_id);
 
@@ -50,12 +62,15 @@ private:
     DocumentID generate_id();
     void sync_tab_modified(DocumentID id);
 
+    PathTable _paths;
+    UndoStore _undo_store;
     Document* _documents[MAX_DOCUMENTS];
     uint32_t _document_count;
     DocumentID _active_id;
     DocumentID _next_id;
     TabBar* _tab_bar;
     Theme* _theme;
+    JobSystem* _job_system;
 };
 
 }
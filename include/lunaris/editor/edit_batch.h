@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+
+class PieceView;
+
+struct BatchEdit {
+    size_t pos;
+    size_t removed;
+    size_t inserted;
+    size_t removed_offset;
+    size_t inserted_offset;
+};
+
+class EditBatch {
+public:
+    EditBatch();
+    ~EditBatch();
+
+    void add(size_t pos, size_t removed, const char* text, size_t len);
+    bool prepare(const PieceView& view);
+    EditBatch* clone() const;
+    void assign(const BatchEdit* edits, uint32_t count, const char* text, size_t text_size);
+    void clear();
+
+    uint32_t get_count() const { return _count; }
+    const BatchEdit& get_edit(uint32_t index) const { return _edits[index]; }
+    const BatchEdit* get_edits() const { return _edits; }
+    const char* get_text() const { return _text; }
+    const char* get_removed_text(uint32_t index) const { return _text + _edits[index].removed_offset; }
+    const char* get_inserted_text(uint32_t index) const { return _text + _edits[index].inserted_offset; }
+    size_t get_text_size() const { return _text_length; }
+
+private:
+    char* reserve_text(size_t len);
+
+    BatchEdit* _edits;
+    uint32_t _count;
+    uint32_t _capacity;
+    char* _text;
+    size_t _text_length;
+    size_t _text_capacity;
+};
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+
+struct EditDelta {
+    size_t pos;
+    size_t removed;
+    size_t inserted;
+    uint32_t version;
+};
+
+class EditJournal {
+public:
+    static constexpr uint32_t CAPACITY = 1024;
+
+    EditJournal();
+
+    void record(size_t pos, size_t removed, size_t inserted, uint32_t version);
+
+    uint64_t get_head() const { return _head; }
+    bool is_valid(uint64_t cursor) const { return cursor <= _head && _head - cursor <= CAPACITY; }
+    bool read(uint64_t& cursor, EditDelta* out, uint32_t max, uint32_t& count) const;
+
+private:
+    EditDelta _deltas[CAPACITY];
+    uint64_t _head;
+};
+
+}
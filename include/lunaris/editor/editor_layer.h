@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace lunaris {
 
 class Workspace;
@@ -20,6 +22,8 @@ class FileOperations;
 
 class EditorLayer {
 public:
+    static constexpr uint32_t FILE_POLL_INTERVAL_MS = 1000;
+
     EditorLayer();
     ~EditorLayer();
 
@@ -52,6 +56,7 @@ private:
     void draw_main_area();
     void register_builtin_commands();
     void handle_keyboard_shortcuts();
+    void schedule_file_poll();
 
     Workspace* _workspace;
     StatusBar* _status_bar;
@@ -68,6 +73,7 @@ private:
     DocumentManager* _document_manager;
     TextEditor* _text_editor;
     FileOperations* _file_operations;
+    bool _indexing_visible;
     bool _first_frame;
 };
 
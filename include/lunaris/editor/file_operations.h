@@ -7,6 +7,8 @@ namespace lunaris {
 
 class DocumentManager;
 class Sidebar;
+class JobSystem;
+class Task;
 
 class FileOperations {
 public:
@@ -18,6 +20,7 @@ public:
 
     void set_document_manager(DocumentManager* mgr) { _doc_manager = mgr; }
     void set_sidebar(Sidebar* sb) { _sidebar = sb; }
+    void set_job_system(JobSystem* jobs) { _job_system = jobs; }
 
     bool create_file(const char* path);
     bool delete_file(const char* path);
@@ -33,18 +36,26 @@ public:
 
     bool file_exists(const char* path) const;
     bool folder_exists(const char* path) const;
-    bool read_file_content(const char* path, char** out_content, size_t* out_len) const;
 
 private:
-    bool write_file(const char* path, const char* content, size_t len);
-    bool remove_file(const char* path);
+    struct PendingCopy {
+        FileOperations* owner;
+        PendingCopy* next;
+        char target[MAX_PATH_LEN];
+    };
+
+    static bool remove_file(const char* path);
     bool make_directory(const char* path);
     bool remove_directory(const char* path);
     bool rename_path(const char* old_path, const char* new_path);
     void get_duplicate_path(const char* path, char* out_path, size_t out_size) const;
+    static Task copy_file(JobSystem* jobs, PendingCopy* copy, const char* path);
+    void finish_copy(PendingCopy* copy, bool written);
 
     DocumentManager* _doc_manager;
     Sidebar* _sidebar;
+    JobSystem* _job_system;
+    PendingCopy* _copies;
 };
 
 }
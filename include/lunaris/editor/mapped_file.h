@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+
+enum class FileChange : uint8_t {
+    None,
+    Modified,
+    Replaced,
+    Removed
+};
+
+class MappedFile {
+public:
+    static constexpr uint32_t MAX_GUARDED_MAPPINGS = 256;
+
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const char* path, bool shared_write = false);
+    void close();
+
+    bool is_open() const { return _open; }
+    const char* get_data() const { return _data; }
+    size_t get_size() const { return _size; }
+
+    bool is_same_file(const char* path) const;
+    FileChange check_changes(const char* path) const;
+    size_t get_readable_size() const;
+    void track_path(const char* path);
+
+private:
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+    uint64_t _write_time;
+#else
+    int _fd;
+    uint32_t _guard;
+    int64_t _mtime;
+    uint64_t _device;
+    uint64_t _inode;
+    uint64_t _path_device;
+    uint64_t _path_inode;
+#endif
+    const char* _data;
+    size_t _size;
+    bool _open;
+};
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+namespace text {
+
+size_t count_newlines(const char* data, size_t len);
+size_t count_newlines_scalar(const char* data, size_t len);
+const char* find_nth_newline(const char* data, size_t len, size_t nth);
+
+const char* get_newline_scan_isa();
+
+}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+
+using PathID = uint32_t;
+constexpr PathID INVALID_PATH_ID = 0;
+
+struct PathEntry {
+    char* path;
+    uint32_t length;
+    uint32_t hash;
+    uint32_t refs;
+    uint32_t next_free;
+};
+
+class PathTable {
+public:
+    static constexpr uint32_t INITIAL_CAPACITY = 64;
+
+    PathTable();
+    ~PathTable();
+
+    PathID intern(const char* path);
+    PathID find(const char* path) const;
+    void retain(PathID id);
+    void release(PathID id);
+
+    const char* get(PathID id) const { return id != INVALID_PATH_ID ? _entries[id].path : ""; }
+    uint32_t get_count() const { return _live; }
+
+private:
+    static uint32_t hash_path(const char* path, uint32_t length);
+    uint32_t find_slot(const char* path, uint32_t length, uint32_t hash) const;
+    void grow_entries();
+    void grow_index();
+
+    PathEntry* _entries;
+    uint32_t _entry_count;
+    uint32_t _entry_capacity;
+    uint32_t _free_head;
+    uint32_t _live;
+
+    PathID* _index;
+    uint32_t _index_capacity;
+    uint32_t _index_used;
+};
+
+}
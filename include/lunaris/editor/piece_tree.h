@@ -0,0 +1,156 @@
+#pragma once
+
+#include "lunaris/core/job.h"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace lunaris {
+
+class JobSystem;
+class MappedFile;
+class EditBatch;
+
+struct TextChunk {
+    char* data;
+    size_t length;
+    size_t capacity;
+    std::atomic<size_t*> line_feed_prefix;
+    MappedFile* mapping;
+    std::atomic<uint32_t> refs;
+};
+
+struct PieceNode {
+    PieceNode* left;
+    PieceNode* right;
+    TextChunk* chunk;
+    size_t start;
+    size_t length;
+    size_t line_feeds;
+    size_t subtree_length;
+    size_t subtree_line_feeds;
+    uint32_t priority;
+    std::atomic<uint32_t> refs;
+};
+
+struct TextSpan {
+    const char* data;
+    size_t length;
+};
+
+class TextIterator {
+public:
+    TextIterator(const PieceNode* root, size_t start, size_t end);
+
+    bool next(TextSpan& span);
+
+private:
+    const PieceNode* _root;
+    size_t _pos;
+    size_t _end;
+};
+
+class PieceView {
+public:
+    explicit PieceView(const PieceNode* root) : _root(root) {}
+
+    size_t get_length() const { return _root ? _root->subtree_length : 0; }
+    size_t get_line_feed_count() const { return _root ? _root->subtree_line_feeds : 0; }
+
+    size_t get_line_start(size_t line) const;
+    size_t get_line_end(size_t line) const;
+    size_t find_line_end(size_t pos) const;
+    size_t get_line_at(size_t pos) const;
+
+    char char_at(size_t pos) const;
+    bool span_at(size_t pos, TextSpan& out) const;
+    size_t copy_range(size_t pos, size_t len, char* out) const;
+    TextIterator get_range(size_t start, size_t end) const { return TextIterator(_root, start, end); }
+
+private:
+    const PieceNode* _root;
+};
+
+class PieceTree {
+public:
+    static constexpr size_t ADD_CHUNK_CAPACITY = 64 * 1024;
+    static constexpr size_t MAX_UNINDEXED_PIECE = 4096;
+    static constexpr size_t LINE_BLOCK_SIZE = 4096;
+    static constexpr size_t PARALLEL_INDEX_THRESHOLD = 32 * 1024 * 1024;
+    static constexpr size_t PARALLEL_INDEX_GRAIN_BLOCKS = 256;
+    static constexpr size_t INDEX_PUBLISH_BLOCKS = 256;
+    static constexpr size_t ESTIMATED_LINE_LENGTH = 64;
+    static constexpr size_t ESTIMATE_SNAP_LIMIT = 64 * 1024;
+
+    PieceTree();
+    ~PieceTree();
+
+    void adopt(char* data, size_t length, JobSystem* jobs = nullptr);
+    void adopt_mapping(MappedFile* mapping, JobSystem* jobs = nullptr);
+    void adopt_deferred(MappedFile* mapping, JobSystem* jobs);
+    bool detach_mapping(size_t readable_length);
+    MappedFile* get_mapping() const;
+    void assign(const char* text, size_t length);
+    void clear();
+
+    void insert(size_t pos, const char* text, size_t len);
+    void remove(size_t pos, size_t len);
+    void apply(const EditBatch& batch, bool revert);
+
+    PieceView view() const { return PieceView(_root); }
+    PieceNode* share_root() const;
+    void replace_root(PieceNode* root);
+    static void release(PieceNode* node);
+
+    size_t get_length() const { return _root ? _root->subtree_length : 0; }
+    size_t get_line_feed_count() const;
+    size_t get_line_start(size_t line) const;
+    size_t get_line_end(size_t line) const;
+    size_t get_line_at(size_t pos) const;
+
+    bool is_indexing() const { return _pending_chunk != nullptr; }
+    float get_index_progress() const;
+    bool finish_indexing();
+
+private:
+    TextChunk* create_chunk(char* data, size_t length, size_t capacity, MappedFile* mapping);
+    void adopt_chunk(TextChunk* chunk, JobSystem* jobs);
+    void index_chunk(TextChunk* chunk, JobSystem* jobs = nullptr);
+    void destroy_chunks();
+    void run_deferred_index(const CancelToken& token);
+    void cancel_indexing();
+    void get_index_state(size_t& indexed_bytes, size_t& indexed_line_feeds, size_t& bytes_per_line) const;
+    size_t estimate_line_start(size_t line) const;
+    size_t estimate_line_at(size_t pos) const;
+    PieceNode* create_node(TextChunk* chunk, size_t start, size_t length, size_t line_feeds, uint32_t priority);
+    uint32_t next_priority();
+
+    bool try_extend(size_t pos, const char* text, size_t len);
+    PieceNode* append_text(const char* text, size_t len);
+    void split(PieceNode* node, size_t pos, PieceNode*& left, PieceNode*& right);
+    PieceNode* merge(PieceNode* left, PieceNode* right);
+    PieceNode* rebind_chunk(PieceNode* node, const TextChunk* from, TextChunk* to);
+    static PieceNode* own(PieceNode* node);
+    static void retain_chunk(TextChunk* chunk);
+    static void release_chunk(TextChunk* chunk);
+    static void update(PieceNode* node);
+    static size_t subtree_length(const PieceNode* node) { return node ? node->subtree_length : 0; }
+    static size_t subtree_line_feeds(const PieceNode* node) { return node ? node->subtree_line_feeds : 0; }
+    static void count_blocks(const TextChunk* chunk, size_t* prefix, size_t first_block, size_t last_block);
+
+    PieceNode* _root;
+    TextChunk* _add_chunk;
+    TextChunk** _chunks;
+    uint32_t _chunk_count;
+    uint32_t _chunk_capacity;
+    uint32_t _seed;
+
+    TextChunk* _pending_chunk;
+    size_t* _pending_prefix;
+    std::atomic<size_t> _indexed_blocks;
+    CancelSource _index_cancel;
+    JobSystem* _index_jobs;
+    JobID _index_job;
+};
+
+}
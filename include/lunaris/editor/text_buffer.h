@@ -1,56 +1,66 @@
 #pragma once
 
+#include "lunaris/editor/piece_tree.h"
+#include "lunaris/editor/text_snapshot.h"
+#include "lunaris/editor/edit_journal.h"
+#include "lunaris/editor/edit_batch.h"
+#include "lunaris/editor/undo_history.h"
+#include "lunaris/editor/mapped_file.h"
 #include <cstdint>
 #include <cstddef>
+#include <cstdio>
 
 namespace lunaris {
 
-enum class EditType : uint8_t {
-    Insert,
-    Remove
-};
-
-struct EditOperation {
-    EditType type;
-    size_t pos;
-    char* text;
-    size_t len;
-    size_t cursor_before;
-    size_t cursor_after;
-};
-
 class TextBuffer {
 public:
-    static constexpr size_t INITIAL_CAPACITY = 4096;
     static constexpr size_t MAX_LINE_COUNT = 1000000;
-    static constexpr size_t MAX_UNDO_HISTORY = 1000;
+    static constexpr size_t MMAP_THRESHOLD = 4 * 1024 * 1024;
+    static constexpr size_t LARGE_FILE_THRESHOLD = 64 * 1024 * 1024;
 
     TextBuffer();
     ~TextBuffer();
 
-    bool load_from_file(const char* path);
+    bool load_from_file(const char* path, JobSystem* jobs = nullptr);
     bool save_to_file(const char* path);
     void set_text(const char* text, size_t length);
+    bool is_mapped() const { return _tree.get_mapping() != nullptr; }
+    FileChange check_backing_file(const char* path) const;
+    bool detach_backing_file();
+
+    bool is_indexing() const { return _tree.is_indexing(); }
+    float get_index_progress() const { return _tree.get_index_progress(); }
+    bool finish_indexing();
     void clear();
 
-    const char* get_text() const { return _data; }
-    size_t get_length() const { return _length; }
-    uint32_t get_line_count() const { return _line_count; }
+    size_t get_length() const { return _tree.get_length(); }
+    uint32_t get_line_count() const { return static_cast<uint32_t>(_tree.get_line_feed_count() + 1); }
+
+    TextIterator get_range(size_t start, size_t end) const { return _tree.view().get_range(start, end); }
+    size_t copy_range(size_t pos, size_t len, char* out) const { return _tree.view().copy_range(pos, len, out); }
+    TextSnapshot* snapshot() const;
 
     void insert(size_t pos, const char* text, size_t len, size_t cursor_pos);
     void remove(size_t pos, size_t len, size_t cursor_pos);
-    void insert_no_history(size_t pos, const char* text, size_t len);
-    void remove_no_history(size_t pos, size_t len);
+    void begin_batch();
+    void batch_replace(size_t pos, size_t removed, const char* text, size_t len);
+    bool commit(size_t cursor_before, size_t cursor_after);
+    bool is_batch_open() const { return _batch_open; }
     char char_at(size_t pos) const;
 
-    bool can_undo() const { return _undo_count > 0; }
-    bool can_redo() const { return _redo_count > 0; }
+    bool can_undo() const { return _history.can_undo(); }
+    bool can_redo() const { return _history.can_redo(); }
     size_t undo();
     size_t redo();
+    void seal_undo_group() { _history.seal(); }
+    UndoHistory& get_history() { return _history; }
+    uint64_t get_undo_sequence() const { return _history.peek_undo_sequence(); }
+    uint64_t get_redo_sequence() const { return _history.peek_redo_sequence(); }
     void clear_history();
 
     size_t get_line_start(uint32_t line) const;
     size_t get_line_end(uint32_t line) const;
+    size_t get_line_end_at(size_t pos) const { return _tree.view().find_line_end(pos); }
     uint32_t get_line_at_pos(size_t pos) const;
     size_t get_column_at_pos(size_t pos) const;
     size_t pos_from_line_col(uint32_t line, size_t col) const;
@@ -59,30 +69,26 @@ public:
     void set_modified(bool modified) { _modified = modified; }
 
     uint32_t get_version() const { return _version; }
+    const EditJournal& get_journal() const { return _journal; }
 
 private:
-    void ensure_capacity(size_t required);
-    void rebuild_line_starts();
     void insert_raw(size_t pos, const char* text, size_t len);
     void remove_raw(size_t pos, size_t len);
-    void push_undo(EditOperation op);
-    void push_redo(EditOperation op);
-    void free_operation(EditOperation& op);
-    void clear_redo();
-
-    char* _data;
-    size_t _length;
-    size_t _capacity;
-    uint32_t _line_count;
-    size_t* _line_starts;
-    size_t _line_starts_capacity;
+    void apply_batch_raw(const EditBatch& batch, bool revert);
+    void journal_batch(const EditBatch& batch, bool revert);
+    void apply_entry(const UndoEntry& entry, bool revert);
+    bool write_to(FILE* f) const;
+#ifndef _WIN32
+    bool save_replacing(const char* path);
+#endif
+
+    PieceTree _tree;
     bool _modified;
     uint32_t _version;
-
-    EditOperation* _undo_stack;
-    size_t _undo_count;
-    EditOperation* _redo_stack;
-    size_t _redo_count;
+    EditJournal _journal;
+    EditBatch _batch;
+    bool _batch_open;
+    UndoHistory _history;
 };
 
 }
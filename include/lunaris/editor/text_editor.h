@@ -10,7 +10,6 @@ class DocumentManager;
 class FileOperations;
 class Theme;
 class TextBuffer;
-struct UndoAction;
 
 class TextEditor {
 public:
@@ -18,6 +17,7 @@ public:
     static constexpr float LINE_HEIGHT_FACTOR = 1.4f;
     static constexpr float LEFT_MARGIN = 8.0f;
     static constexpr float TOP_MARGIN = 8.0f;
+    static constexpr float READ_ONLY_NOTICE_SECONDS = 2.0f;
 
     TextEditor();
     ~TextEditor();
@@ -29,6 +29,12 @@ public:
 
     void on_ui();
     void focus() { _focus_requested = true; }
+    void go_to_line(uint32_t line);
+
+    void undo();
+    void redo();
+    void undo_across_files();
+    void redo_across_files();
 
 private:
     void handle_keyboard_input();
@@ -37,9 +43,13 @@ private:
     void draw_text(float x, float y, float width, float height);
     void draw_cursor(float x, float y);
     void draw_selection(float x, float y, float width);
+    void draw_read_only_badge(float right, float top);
 
+    bool begin_edit();
     void insert_text(const char* text, size_t len);
     void delete_range(size_t start, size_t end);
+    void replace_selection(const char* text, size_t len);
+    void indent_selection();
     void delete_char_before();
     void delete_char_after();
 
@@ -57,10 +67,8 @@ private:
     void cut_selection();
     void paste();
 
-    void undo();
-    void redo();
-    bool handle_text_undo(UndoAction* action);
-    bool handle_text_redo(UndoAction* action);
+    void activate_document(Document* doc);
+    void set_cursor(size_t pos);
 
     void ensure_cursor_visible();
     float get_gutter_width() const;
@@ -68,6 +76,7 @@ private:
     size_t pos_from_coords(float x, float y) const;
     void get_cursor_coords(float& x, float& y) const;
     bool is_word_char(char c) const;
+    const char* fetch_range(size_t start, size_t end) const;
 
     Document* _document;
     DocumentManager* _doc_manager;
@@ -85,6 +94,9 @@ private:
     float _blink_timer;
     bool _cursor_visible;
     bool _dragging;
+    float _read_only_notice;
+    mutable char* _scratch;
+    mutable size_t _scratch_capacity;
 };
 
 }
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "lunaris/editor/piece_tree.h"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace lunaris {
+
+class TextSnapshot {
+public:
+    TextSnapshot(PieceNode* root, uint32_t version, bool line_index);
+
+    void retain();
+    void release();
+
+    uint32_t get_version() const { return _version; }
+    bool has_line_index() const { return _line_index; }
+    PieceView get_view() const { return PieceView(_root); }
+    size_t get_length() const { return _root ? _root->subtree_length : 0; }
+    uint32_t get_line_count() const { return static_cast<uint32_t>(get_view().get_line_feed_count() + 1); }
+
+private:
+    ~TextSnapshot();
+
+    PieceNode* _root;
+    uint32_t _version;
+    bool _line_index;
+    std::atomic<uint32_t> _refs;
+};
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace lunaris {
+
+class EditBatch;
+class MappedFile;
+struct PieceNode;
+
+enum class EditType : uint8_t {
+    Insert,
+    Remove,
+    Batch
+};
+
+struct UndoEntry {
+    EditType type;
+    bool mapped;
+    bool checkpoint;
+    uint64_t block;
+    size_t pos;
+    size_t len;
+    char* text;
+    size_t cursor_before;
+    size_t cursor_after;
+    EditBatch* batch;
+    PieceNode* root_before;
+    PieceNode* root_after;
+    uint64_t sequence;
+};
+
+struct UndoBlock {
+    char* data;
+    size_t capacity;
+    size_t used;
+};
+
+class UndoHistory {
+public:
+    static constexpr uint32_t MAX_ENTRIES = 4096;
+    static constexpr uint32_t MAX_BLOCKS = 1024;
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_GROUP_LENGTH = 256;
+    static constexpr int64_t GROUP_PAUSE_MS = 1000;
+    static constexpr size_t CHECKPOINT_LENGTH = 64 * 1024;
+    static constexpr uint32_t CHECKPOINT_EDITS = 64;
+
+    UndoHistory();
+    ~UndoHistory();
+
+    void record_insert(size_t pos, const char* text, size_t len, size_t cursor_before);
+    char* record_remove(size_t pos, size_t len, size_t cursor_before);
+    void record_batch(EditBatch* batch, size_t cursor_before, size_t cursor_after);
+    void seal() { _sealed = true; }
+    void attach_checkpoint(PieceNode* root_before, PieceNode* root_after);
+    void drop_checkpoints();
+
+    void restore(MappedFile* log, const UndoEntry* entries, uint32_t count, uint32_t cursor, uint64_t base_index);
+    void mark_queued();
+    void mark_logged(uint64_t end_index, uint32_t epoch);
+    void reset_log();
+
+    const UndoEntry* undo();
+    const UndoEntry* redo();
+
+    bool can_undo() const { return _cursor > 0; }
+    bool can_redo() const { return _cursor < _count; }
+    size_t get_byte_usage() const { return _bytes; }
+    uint32_t get_count() const { return _count; }
+    uint32_t get_cursor() const { return _cursor; }
+    uint32_t get_logged() const { return _logged; }
+    uint32_t get_queued() const { return _queued; }
+    uint64_t get_base_index() const { return _base_index; }
+    bool is_log_reset() const { return _log_reset; }
+    uint32_t get_log_epoch() const { return _log_epoch; }
+    const UndoEntry& get_entry(uint32_t index) const { return entry_at(index); }
+    uint64_t peek_undo_sequence() const { return _cursor > 0 ? entry_at(_cursor - 1).sequence : 0; }
+    uint64_t peek_redo_sequence() const { return _cursor < _count ? entry_at(_cursor).sequence : 0; }
+    void clear();
+
+private:
+    UndoEntry& entry_at(uint32_t index) { return _entries[(_first + index) % MAX_ENTRIES]; }
+    const UndoEntry& entry_at(uint32_t index) const { return _entries[(_first + index) % MAX_ENTRIES]; }
+    UndoBlock& block_at(uint64_t seq) { return _blocks[seq % MAX_BLOCKS]; }
+    UndoEntry& push(EditType type, size_t pos, size_t len, size_t cursor_before, size_t cursor_after);
+    bool try_extend(size_t pos, const char* text, size_t len);
+    char* allocate_text(UndoEntry& entry, size_t len);
+    void release_blocks_before(uint64_t seq);
+    void release_newest_block();
+    static void release_checkpoint(UndoEntry& entry);
+    static void release_entry(UndoEntry& entry);
+    void drop_redo();
+    void drop_oldest();
+    void enforce_budget();
+    static size_t batch_bytes(const EditBatch* batch);
+
+    UndoEntry* _entries;
+    uint32_t _first;
+    uint32_t _count;
+    uint32_t _cursor;
+
+    UndoBlock* _blocks;
+    uint64_t _first_block;
+    uint64_t _next_block;
+    char* _spare_block;
+
+    MappedFile* _log;
+    uint64_t _base_index;
+    uint32_t _logged;
+    uint32_t _queued;
+    bool _log_reset;
+    uint32_t _log_epoch;
+
+    size_t _bytes;
+    int64_t _last_edit_ms;
+    bool _sealed;
+};
+
+}
@@ -1,15 +1,12 @@
 #pragma once
 
+#include "lunaris/editor/path_table.h"
 #include <cstdint>
 #include <cstddef>
 
 namespace lunaris {
 
-using DocumentID = uint32_t;
-
 enum class UndoActionType : uint8_t {
-    TextInsert,
-    TextDelete,
     FileCreate,
     FileDelete,
     FileRename,
@@ -20,27 +17,22 @@ enum class UndoActionType : uint8_t {
 
 struct UndoAction {
     UndoActionType type;
-    DocumentID doc_id;
-    size_t pos;
-    char* text;
-    size_t len;
-    size_t cursor_before;
-    size_t cursor_after;
-    char* path;
-    char* path_alt;
+    uint64_t sequence;
+    PathID path;
+    PathID path_alt;
     char* content;
     size_t content_len;
 };
 
 class UndoManager {
 public:
-    static constexpr size_t MAX_HISTORY = 1000;
-    static constexpr size_t MAX_PATH_LEN = 1024;
+    static constexpr size_t MAX_HISTORY = 4096;
 
     static UndoManager& instance();
 
-    void record_text_insert(DocumentID doc_id, const char* filepath, size_t pos, const char* text, size_t len, size_t cursor_before, size_t cursor_after);
-    void record_text_delete(DocumentID doc_id, const char* filepath, size_t pos, const char* text, size_t len, size_t cursor_before, size_t cursor_after);
+    void set_path_table(PathTable* paths) { _paths = paths; }
+
+    uint64_t next_sequence() { return _next_sequence++; }
 
     void record_file_create(const char* path);
     void record_file_delete(const char* path, const char* content, size_t content_len);
@@ -50,8 +42,9 @@ public:
     void record_folder_delete(const char* path);
     void record_folder_rename(const char* old_path, const char* new_path);
 
-    bool can_undo() const { return _undo_count > 0; }
-    bool can_redo() const { return _redo_count > 0; }
+    size_t get_byte_usage() const { return _bytes; }
+    bool can_undo() const { return _cursor > 0; }
+    bool can_redo() const { return _cursor < _count; }
 
     const UndoAction* peek_undo() const;
     const UndoAction* peek_redo() const;
@@ -60,25 +53,25 @@ public:
     UndoAction* redo();
 
     void clear();
-    void clear_for_document(DocumentID doc_id);
-
-    bool is_text_action(UndoActionType type) const;
-    bool is_file_action(UndoActionType type) const;
 
 private:
     UndoManager();
     ~UndoManager();
 
-    void push_undo(UndoAction action);
-    void push_redo(UndoAction action);
-    void clear_redo();
+    UndoAction& action_at(size_t index) { return _actions[(_first + index) % MAX_HISTORY]; }
+    const UndoAction& action_at(size_t index) const { return _actions[(_first + index) % MAX_HISTORY]; }
+    void push(UndoAction action);
+    void drop_oldest();
     void free_action(UndoAction& action);
-    UndoAction copy_action(const UndoAction& action);
-
-    UndoAction* _undo_stack;
-    size_t _undo_count;
-    UndoAction* _redo_stack;
-    size_t _redo_count;
+    static size_t action_bytes(const UndoAction& action);
+
+    UndoAction* _actions;
+    size_t _first;
+    size_t _count;
+    size_t _cursor;
+    size_t _bytes;
+    uint64_t _next_sequence;
+    PathTable* _paths;
 };
 
 }
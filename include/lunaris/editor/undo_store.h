@@ -0,0 +1,94 @@
+#pragma once
+
+#include "lunaris/core/job.h"
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+namespace lunaris {
+
+class JobSystem;
+class TextBuffer;
+class TextSnapshot;
+class MappedFile;
+struct UndoEntry;
+
+struct UndoRestore {
+    TextBuffer* buffer;
+    TextSnapshot* snapshot;
+    uint32_t version;
+    MappedFile* log;
+    UndoEntry* entries;
+    uint32_t count;
+    uint32_t cursor;
+    uint64_t base;
+    JobID apply;
+    UndoRestore* next;
+};
+
+struct UndoCommit {
+    TextBuffer* buffer;
+    uint64_t end_index;
+    uint32_t epoch;
+    bool written;
+    JobID apply;
+    UndoCommit* next;
+};
+
+struct UndoLogRequest {
+    char* path;
+    char* data;
+    size_t size;
+    TextSnapshot* snapshot;
+    UndoRestore* restore;
+    UndoCommit* commit;
+    bool truncate;
+};
+
+class UndoStore {
+public:
+    static constexpr size_t MAX_DIRECTORY_LENGTH = 1024;
+    static constexpr uint32_t MAX_QUEUED_REQUESTS = 64;
+
+    UndoStore();
+    ~UndoStore();
+
+    void set_job_system(JobSystem* jobs) { _job_system = jobs; }
+    void set_workspace(const char* root);
+    bool is_enabled() const { return _directory[0] != '\0'; }
+
+    void save(const char* filepath, TextBuffer* buffer);
+    void save_as(const char* filepath, TextBuffer* buffer);
+    void restore(const char* filepath, TextBuffer* buffer);
+    void detach_buffer(TextBuffer* buffer);
+    void wait_idle();
+
+private:
+    void get_log_path(const char* filepath, char* out, size_t out_size) const;
+    void cancel_restore(TextBuffer* buffer);
+    void enqueue(const char* path, char* data, size_t size, TextSnapshot* snapshot, UndoRestore* restore, UndoCommit* commit, bool truncate);
+    void drain();
+    void process(const UndoLogRequest& request);
+    void apply_result(UndoRestore* restore, UndoCommit* commit);
+    void apply_restore(UndoRestore* restore);
+    void apply_commit(UndoCommit* commit);
+    static bool write_log(const UndoLogRequest& request);
+    static void read_log(const char* path, UndoRestore* restore);
+    static void free_restore(UndoRestore* restore);
+
+    char _root[MAX_DIRECTORY_LENGTH];
+    char _directory[MAX_DIRECTORY_LENGTH];
+    JobSystem* _job_system;
+
+    UndoLogRequest _queue[MAX_QUEUED_REQUESTS];
+    uint32_t _queue_head;
+    uint32_t _queue_count;
+    bool _draining;
+    UndoRestore* _restores;
+    UndoCommit* _commits;
+    std::mutex _mutex;
+    std::condition_variable _idle_cv;
+};
+
+}
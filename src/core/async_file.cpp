@@ -0,0 +1,105 @@
+#include "lunaris/core/async_file.h"
+#include <cstdio>
+#include <cstring>
+
+namespace lunaris {
+
+char* read_whole_file(const char* path, size_t& out_length) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return nullptr;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    if (size < 0) {
+        fclose(f);
+        return nullptr;
+    }
+
+    char* data = new char[size > 0 ? static_cast<size_t>(size) : 1];
+    out_length = fread(data, 1, static_cast<size_t>(size), f);
+    fclose(f);
+    return data;
+}
+
+bool write_whole_file(const char* path, const char* data, size_t length) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+
+    size_t written = fwrite(data, 1, length, f);
+    return fclose(f) == 0 && written == length;
+}
+
+static void copy_path(char* dest, const char* path, size_t capacity) {
+    size_t len = strlen(path);
+    if (len >= capacity) {
+        dest[0] = '\0';
+        return;
+    }
+    memcpy(dest, path, len + 1);
+}
+
+static void resume_on(JobSystem* jobs, JobTarget target, std::coroutine_handle<> handle) {
+    if (target != JobTarget::Io && jobs->submit_lambda_after(nullptr, 0, [handle]() {
+        handle.resume();
+    }, "ResumeTask", JobPriority::Normal, target) != INVALID_JOB_ID) {
+        return;
+    }
+    handle.resume();
+}
+
+FileReadAwaiter::FileReadAwaiter(JobSystem* jobs, const char* path, JobTarget resume_target)
+    : _jobs(jobs)
+    , _target(resume_target) {
+    _result.data = nullptr;
+    _result.length = 0;
+    copy_path(_path, path, MAX_PATH_LEN);
+}
+
+bool FileReadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    JobID id = INVALID_JOB_ID;
+    if (_jobs) {
+        id = _jobs->submit_io([this, handle]() {
+            _result.data = read_whole_file(_path, _result.length);
+            resume_on(_jobs, _target, handle);
+        }, "ReadFile");
+    }
+
+    if (id == INVALID_JOB_ID) {
+        _result.data = read_whole_file(_path, _result.length);
+        return false;
+    }
+    return true;
+}
+
+FileWriteAwaiter::FileWriteAwaiter(JobSystem* jobs, const char* path, const char* data, size_t length, JobTarget resume_target)
+    : _jobs(jobs)
+    , _target(resume_target)
+    , _data(data)
+    , _length(length)
+    , _ok(false) {
+    copy_path(_path, path, MAX_PATH_LEN);
+}
+
+bool FileWriteAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    JobID id = INVALID_JOB_ID;
+    if (_jobs) {
+        id = _jobs->submit_io([this, handle]() {
+            _ok = write_whole_file(_path, _data, _length);
+            resume_on(_jobs, _target, handle);
+        }, "WriteFile");
+    }
+
+    if (id == INVALID_JOB_ID) {
+        _ok = write_whole_file(_path, _data, _length);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -1,26 +1,78 @@
 #include "lunaris/core/job_system.h"
+#include <chrono>
+#include <cstdio>
 
 namespace lunaris {
 
+static thread_local JobSystem* t_system = nullptr;
+static thread_local uint32_t t_worker = JobSystem::MAX_WORKERS;
+static thread_local const JobSystem* t_lane_system = nullptr;
+static thread_local uint32_t t_lane = 0;
+static thread_local const JobSystem* t_main_system = nullptr;
+static thread_local uint32_t t_active_depth = 0;
+static thread_local uint64_t t_nested_ns = 0;
+
+static uint32_t next_random(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
 JobSystem::JobSystem()
-    : _pending_count(0)
+    : _workers(nullptr)
     , _worker_count(0)
-    , _running(false)
-    , _next_id(1) {
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        _pending_jobs[i].job = nullptr;
-        _pending_jobs[i].owns_memory = false;
+    , _io_worker_count(0)
+    , _io_queued(0)
+    , _io_sleepers(0)
+    , _timer_thread(nullptr)
+    , _timer_tick(0)
+    , _timer_next(UINT64_MAX)
+    , _timer_count(0)
+    , _epoch(std::chrono::steady_clock::now())
+    , _profiling(false)
+    , _profile_start_ns(0)
+    , _events(nullptr)
+    , _event_head(0)
+    , _event_first(0)
+    , _slot_page_count(0)
+    , _free_slots(0)
+    , _main_posted(0)
+    , _main_head(0)
+    , _main_tail(0)
+    , _main_wake(0)
+    , _main_waiters(0)
+    , _queued(0)
+    , _active(0)
+    , _active_waiters(0)
+    , _sleepers(0)
+    , _running(false) {
+    for (uint32_t i = 0; i < MAX_IO_WORKERS; ++i) {
+        _io_threads[i] = nullptr;
+    }
+    for (uint32_t i = 0; i < TIMER_WHEEL_SIZE; ++i) {
+        _timer_wheel[i] = 0;
     }
-    for (uint32_t i = 0; i < MAX_WORKERS; ++i) {
-        _workers[i] = nullptr;
+    for (uint32_t i = 0; i < MAX_LANES; ++i) {
+        _lane_stats[i].busy_ns.store(0, std::memory_order_relaxed);
+        _lane_stats[i].wait_ns.store(0, std::memory_order_relaxed);
+        _lane_stats[i].jobs.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < MAX_SLOT_PAGES; ++i) {
+        _slot_pages[i] = nullptr;
     }
 }
 
 JobSystem::~JobSystem() {
     shutdown();
+    uint32_t page_count = _slot_page_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < page_count; ++i) {
+        delete[] _slot_pages[i];
+    }
+    delete[] _events;
 }
 
-void JobSystem::init(uint32_t worker_count) {
+void JobSystem::init(uint32_t worker_count, uint32_t io_worker_count) {
     if (_running.load()) {
         return;
     }
@@ -36,12 +88,33 @@ void JobSystem::init(uint32_t worker_count) {
         worker_count = MAX_WORKERS;
     }
 
+    if (io_worker_count == 0) {
+        io_worker_count = DEFAULT_IO_WORKERS;
+    }
+
+    if (io_worker_count > MAX_IO_WORKERS) {
+        io_worker_count = MAX_IO_WORKERS;
+    }
+
     _running.store(true);
+    t_main_system = this;
     _worker_count = worker_count;
+    _workers = new Worker[_worker_count];
 
     for (uint32_t i = 0; i < _worker_count; ++i) {
-        _workers[i] = new std::thread(&JobSystem::worker_thread, this, i);
+        _workers[i].seed = (i + 1) * 0x9E3779B9u;
+        _workers[i].free_count = 0;
+        _workers[i].thread = new std::thread(&JobSystem::worker_thread, this, i);
+    }
+
+    _io_worker_count = io_worker_count;
+    for (uint32_t i = 0; i < _io_worker_count; ++i) {
+        _io_threads[i] = new std::thread(&JobSystem::io_thread, this, i);
     }
+
+    _timer_tick = 0;
+    _timer_next = UINT64_MAX;
+    _timer_thread = new std::thread(&JobSystem::timer_thread, this);
 }
 
 void JobSystem::shutdown() {
@@ -50,151 +123,903 @@ void JobSystem::shutdown() {
     }
 
     _running.store(false);
-    _queue_cv.notify_all();
+    if (t_main_system == this) {
+        t_main_system = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _wake_cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_io_mutex);
+        _io_cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_timer_mutex);
+        _timer_cv.notify_all();
+    }
 
     for (uint32_t i = 0; i < _worker_count; ++i) {
-        if (_workers[i]) {
-            _workers[i]->join();
-            delete _workers[i];
-            _workers[i] = nullptr;
+        _workers[i].thread->join();
+        delete _workers[i].thread;
+    }
+
+    for (uint32_t i = 0; i < _io_worker_count; ++i) {
+        _io_threads[i]->join();
+        delete _io_threads[i];
+        _io_threads[i] = nullptr;
+    }
+    _io_worker_count = 0;
+
+    _timer_thread->join();
+    delete _timer_thread;
+    _timer_thread = nullptr;
+
+    for (uint32_t i = 0; i < TIMER_WHEEL_SIZE; ++i) {
+        uint32_t link = _timer_wheel[i];
+        _timer_wheel[i] = 0;
+        while (link != 0) {
+            uint32_t next = slot_at(link - 1).next.load(std::memory_order_relaxed);
+            fire_timer(link - 1);
+            link = next;
         }
     }
+    _timer_count = 0;
+
+    uint32_t slot = 0;
+    while (_io_queue.pop(slot)) {
+        finish_job(slot, JobState::Cancelled);
+    }
+    _io_queued.store(0);
 
-    std::lock_guard<std::mutex> lock(_queue_mutex);
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        if (_pending_jobs[i].job && _pending_jobs[i].owns_memory) {
-            delete _pending_jobs[i].job;
+    for (uint32_t p = 0; p < PRIORITY_COUNT; ++p) {
+        while (_injected[p].pop(slot)) {
+            finish_job(slot, JobState::Cancelled);
         }
-        _pending_jobs[i].job = nullptr;
-        _pending_jobs[i].owns_memory = false;
+        for (uint32_t i = 0; i < _worker_count; ++i) {
+            while (_workers[i].deques[p].pop(slot)) {
+                finish_job(slot, JobState::Cancelled);
+            }
+        }
+    }
+
+    _queued.store(0);
+
+    uint32_t link = _main_posted.exchange(0, std::memory_order_acquire);
+    while (link != 0) {
+        uint32_t next = slot_at(link - 1).next.load(std::memory_order_relaxed);
+        finish_job(link - 1, JobState::Cancelled);
+        link = next;
+    }
+    while (_main_head != 0) {
+        uint32_t index = _main_head - 1;
+        _main_head = slot_at(index).next.load(std::memory_order_relaxed);
+        finish_job(index, JobState::Cancelled);
     }
-    _pending_count = 0;
+    _main_tail = 0;
+
+    for (uint32_t i = 0; i < _worker_count; ++i) {
+        while (_workers[i].free_count > 0) {
+            release_slot(_workers[i].free_slots[--_workers[i].free_count]);
+        }
+    }
+
+    delete[] _workers;
+    _workers = nullptr;
+    _worker_count = 0;
 }
 
-JobID JobSystem::generate_id() {
-    return _next_id.fetch_add(1);
+void JobSystem::add_slot_page() {
+    std::lock_guard<std::mutex> lock(_grow_mutex);
+    if (static_cast<uint32_t>(_free_slots.load(std::memory_order_acquire)) != 0) {
+        return;
+    }
+
+    uint32_t page = _slot_page_count.load(std::memory_order_relaxed);
+    if (page == MAX_SLOT_PAGES) {
+        return;
+    }
+
+    JobSlot* slots = new JobSlot[SLOT_PAGE_SIZE];
+    for (uint32_t i = 0; i < SLOT_PAGE_SIZE; ++i) {
+        slots[i].job = nullptr;
+        slots[i].generation.store(1, std::memory_order_relaxed);
+        slots[i].next.store(0, std::memory_order_relaxed);
+        slots[i].continuations.store((static_cast<uint64_t>(1) << 32) | JobSlot::CLOSED_LINK, std::memory_order_relaxed);
+        slots[i].dependencies.store(0, std::memory_order_relaxed);
+        slots[i].ready_ns = 0;
+    }
+    _slot_pages[page] = slots;
+    _slot_page_count.store(page + 1, std::memory_order_release);
+
+    for (uint32_t i = SLOT_PAGE_SIZE; i > 0; --i) {
+        release_slot(page * SLOT_PAGE_SIZE + i - 1);
+    }
+}
+
+bool JobSystem::acquire_slot(uint32_t& index) {
+    uint64_t head = _free_slots.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t top = static_cast<uint32_t>(head);
+        if (top == 0) {
+            return false;
+        }
+        uint64_t next = slot_at(top - 1).next.load(std::memory_order_relaxed);
+        uint64_t desired = (((head >> 32) + 1) << 32) | next;
+        if (_free_slots.compare_exchange_weak(head, desired, std::memory_order_acquire, std::memory_order_acquire)) {
+            index = top - 1;
+            return true;
+        }
+    }
+}
+
+void JobSystem::release_slot(uint32_t index) {
+    JobSlot& slot = slot_at(index);
+    uint64_t head = _free_slots.load(std::memory_order_relaxed);
+    uint64_t desired = 0;
+    do {
+        slot.next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        desired = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!_free_slots.compare_exchange_weak(head, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+uint32_t JobSystem::claim_slot() {
+    if (t_system == this) {
+        Worker& worker = _workers[t_worker];
+        if (worker.free_count > 0) {
+            return worker.free_slots[--worker.free_count];
+        }
+    }
+
+    uint32_t index = 0;
+    while (!acquire_slot(index)) {
+        add_slot_page();
+        if (acquire_slot(index)) {
+            break;
+        }
+        uint32_t other = 0;
+        if (find_job(current_worker(), other)) {
+            run_job(other);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return index;
+}
+
+void JobSystem::recycle_slot(uint32_t index) {
+    if (t_system == this) {
+        Worker& worker = _workers[t_worker];
+        if (worker.free_count < SLOT_CACHE_SIZE) {
+            worker.free_slots[worker.free_count++] = index;
+            return;
+        }
+    }
+    release_slot(index);
 }
 
 JobID JobSystem::submit(Job* job) {
+    return submit_after(nullptr, 0, job);
+}
+
+JobID JobSystem::submit_after(const JobID* dependencies, uint32_t count, Job* job) {
     if (!job || !_running.load()) {
         return INVALID_JOB_ID;
     }
 
-    std::lock_guard<std::mutex> lock(_queue_mutex);
+    JobID joined = INVALID_JOB_ID;
+    if (count > JobSlot::MAX_DEPENDENCIES) {
+        joined = when_all(dependencies, count);
+        dependencies = &joined;
+        count = 1;
+    }
+
+    uint32_t index = claim_slot();
+    slot_at(index).pooled = false;
+    return enqueue(index, job, dependencies, count, 0);
+}
 
-    if (_pending_count >= MAX_PENDING_JOBS) {
-        return INVALID_JOB_ID;
+JobID JobSystem::when_all(const JobID* ids, uint32_t count) {
+    if (count <= JobSlot::MAX_DEPENDENCIES) {
+        return submit_lambda_after(ids, count, []() {}, "JoinJobs");
+    }
+
+    JobID groups[JobSlot::MAX_DEPENDENCIES];
+    uint32_t group_size = (count + JobSlot::MAX_DEPENDENCIES - 1) / JobSlot::MAX_DEPENDENCIES;
+    uint32_t group_count = 0;
+    for (uint32_t first = 0; first < count; first += group_size) {
+        groups[group_count++] = when_all(ids + first, count - first < group_size ? count - first : group_size);
     }
+    return when_all(groups, group_count);
+}
 
-    JobID id = generate_id();
+JobID JobSystem::enqueue(uint32_t index, Job* job, const JobID* dependencies, uint32_t count, uint32_t delay_ms) {
+    JobSlot& slot = slot_at(index);
+    uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+    JobID id = (static_cast<JobID>(generation) << 32) | (index + 1);
+    if (job->get_target() != JobTarget::MainThread && delay_ms == 0) {
+        _active.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot.job = job;
     job->set_id(id);
     job->set_state(JobState::Pending);
+    slot.dependencies.store(count + 1, std::memory_order_relaxed);
+    slot.continuations.store(static_cast<uint64_t>(generation) << 32, std::memory_order_release);
 
-    uint32_t insert_idx = 0;
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        if (_pending_jobs[i].job == nullptr) {
-            insert_idx = i;
-            break;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!add_continuation(dependencies[i], index, i)) {
+            release_dependency(index);
         }
     }
+    if (delay_ms > 0) {
+        add_timer(index, delay_ms);
+    } else {
+        release_dependency(index);
+    }
 
-    _pending_jobs[insert_idx].job = job;
-    _pending_jobs[insert_idx].owns_memory = true;
-    _pending_count++;
+    return id;
+}
 
-    _queue_cv.notify_one();
+bool JobSystem::add_continuation(JobID predecessor, uint32_t successor, uint32_t link) {
+    uint32_t index = static_cast<uint32_t>(predecessor) - 1;
+    if (predecessor == INVALID_JOB_ID || index / SLOT_PAGE_SIZE >= _slot_page_count.load(std::memory_order_acquire)) {
+        return false;
+    }
 
-    return id;
+    JobSlot& slot = slot_at(index);
+    uint32_t generation = static_cast<uint32_t>(predecessor >> 32);
+    uint64_t desired = (static_cast<uint64_t>(generation) << 32) | (successor * JobSlot::MAX_DEPENDENCIES + link + 1);
+    uint64_t head = slot.continuations.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head >> 32) == generation && static_cast<uint32_t>(head) != JobSlot::CLOSED_LINK) {
+        slot_at(successor).links[link] = static_cast<uint32_t>(head);
+        if (slot.continuations.compare_exchange_weak(head, desired, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-Job* JobSystem::pop_job() {
-    std::unique_lock<std::mutex> lock(_queue_mutex);
+void JobSystem::release_dependency(uint32_t index) {
+    if (slot_at(index).dependencies.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (_running.load()) {
+        schedule(index);
+    } else {
+        finish_job(index, JobState::Cancelled);
+    }
+}
 
-    _queue_cv.wait(lock, [this]() {
-        return !_running.load() || _pending_count > 0;
-    });
+void JobSystem::schedule(uint32_t index) {
+    JobSlot& slot = slot_at(index);
+    slot.ready_ns = _profiling.load(std::memory_order_relaxed) ? now_ns() : 0;
+    Job* job = slot.job;
+    if (job->get_target() == JobTarget::MainThread) {
+        post_main(index);
+        return;
+    }
+
+    if (job->get_target() == JobTarget::Io) {
+        _io_queued.fetch_add(1);
+        _io_queue.push(index);
+        wake_io();
+        return;
+    }
+
+    uint32_t priority = static_cast<uint32_t>(job->get_priority());
+    _queued.fetch_add(1);
+    if (t_system == this) {
+        _workers[t_worker].deques[priority].push(index);
+    } else {
+        _injected[priority].push(index);
+    }
+    wake_one();
+}
+
+void JobSystem::post_main(uint32_t index) {
+    JobSlot& slot = slot_at(index);
+    uint32_t head = _main_posted.load(std::memory_order_relaxed);
+    do {
+        slot.next.store(head, std::memory_order_relaxed);
+    } while (!_main_posted.compare_exchange_weak(head, index + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+    if (_main_waiters.load(std::memory_order_seq_cst) > 0) {
+        wake_main_thread();
+    }
+}
+
+void JobSystem::wake_main_thread() {
+    _main_wake.fetch_add(1, std::memory_order_seq_cst);
+    _main_wake.notify_all();
+}
 
-    if (!_running.load() && _pending_count == 0) {
-        return nullptr;
+void JobSystem::collect_main_posted() {
+    uint32_t link = _main_posted.exchange(0, std::memory_order_seq_cst);
+    uint32_t first = 0;
+    uint32_t last = link;
+    while (link != 0) {
+        JobSlot& slot = slot_at(link - 1);
+        uint32_t next = slot.next.load(std::memory_order_relaxed);
+        slot.next.store(first, std::memory_order_relaxed);
+        first = link;
+        link = next;
     }
+    if (first != 0) {
+        if (_main_tail != 0) {
+            slot_at(_main_tail - 1).next.store(first, std::memory_order_relaxed);
+        } else {
+            _main_head = first;
+        }
+        _main_tail = last;
+    }
+}
 
-    Job* best_job = nullptr;
-    uint32_t best_idx = 0;
-    JobPriority best_priority = JobPriority::Low;
+uint32_t JobSystem::drain_main_thread(float budget_ms) {
+    collect_main_posted();
 
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        if (_pending_jobs[i].job && _pending_jobs[i].job->get_state() == JobState::Pending) {
-            JobPriority p = _pending_jobs[i].job->get_priority();
-            if (!best_job || static_cast<uint8_t>(p) > static_cast<uint8_t>(best_priority)) {
-                best_job = _pending_jobs[i].job;
-                best_idx = i;
-                best_priority = p;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t ran = 0;
+    while (_main_head != 0) {
+        uint32_t index = _main_head - 1;
+        _main_head = slot_at(index).next.load(std::memory_order_relaxed);
+        if (_main_head == 0) {
+            _main_tail = 0;
+        }
+        run_job(index);
+        ++ran;
+        if (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= budget_ms) {
+            break;
+        }
+    }
+    return ran;
+}
+
+uint64_t JobSystem::timer_now_ms() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _epoch).count());
+}
+
+void JobSystem::add_timer(uint32_t index, uint32_t delay_ms) {
+    std::lock_guard<std::mutex> lock(_timer_mutex);
+    uint64_t now = timer_now_ms();
+    if (_timer_count == 0 && _timer_tick < now / TIMER_TICK_MS) {
+        _timer_tick = now / TIMER_TICK_MS;
+    }
+
+    uint64_t target = (now + delay_ms) / TIMER_TICK_MS + 1;
+    if (target < _timer_tick) {
+        target = _timer_tick;
+    }
+
+    JobSlot& slot = slot_at(index);
+    uint32_t bucket = static_cast<uint32_t>(target) & (TIMER_WHEEL_SIZE - 1);
+    slot.timer_rounds = static_cast<uint32_t>((target - _timer_tick) >> TIMER_WHEEL_BITS);
+    slot.next.store(_timer_wheel[bucket], std::memory_order_relaxed);
+    _timer_wheel[bucket] = index + 1;
+    ++_timer_count;
+
+    if (target < _timer_next) {
+        _timer_next = target;
+        _timer_cv.notify_one();
+    }
+}
+
+void JobSystem::advance_timers(uint64_t now) {
+    for (; _timer_tick <= now; ++_timer_tick) {
+        uint32_t bucket = static_cast<uint32_t>(_timer_tick) & (TIMER_WHEEL_SIZE - 1);
+        uint32_t prev = 0;
+        uint32_t link = _timer_wheel[bucket];
+        while (link != 0) {
+            JobSlot& slot = slot_at(link - 1);
+            uint32_t next = slot.next.load(std::memory_order_relaxed);
+            if (slot.timer_rounds > 0) {
+                --slot.timer_rounds;
+                prev = link;
+            } else {
+                if (prev != 0) {
+                    slot_at(prev - 1).next.store(next, std::memory_order_relaxed);
+                } else {
+                    _timer_wheel[bucket] = next;
+                }
+                --_timer_count;
+                fire_timer(link - 1);
             }
+            link = next;
         }
     }
 
-    if (best_job) {
-        best_job->set_state(JobState::Running);
-        _pending_jobs[best_idx].job = nullptr;
-        _pending_jobs[best_idx].owns_memory = false;
-        _pending_count--;
+    _timer_next = UINT64_MAX;
+    for (uint32_t i = 0; i < TIMER_WHEEL_SIZE; ++i) {
+        uint64_t visit = _timer_tick + ((i - static_cast<uint32_t>(_timer_tick)) & (TIMER_WHEEL_SIZE - 1));
+        for (uint32_t link = _timer_wheel[i]; link != 0; link = slot_at(link - 1).next.load(std::memory_order_relaxed)) {
+            uint64_t target = visit + (static_cast<uint64_t>(slot_at(link - 1).timer_rounds) << TIMER_WHEEL_BITS);
+            if (target < _timer_next) {
+                _timer_next = target;
+            }
+        }
     }
+}
 
-    return best_job;
+void JobSystem::fire_timer(uint32_t index) {
+    if (slot_at(index).job->get_target() != JobTarget::MainThread) {
+        _active.fetch_add(1, std::memory_order_relaxed);
+    }
+    release_dependency(index);
+}
+
+void JobSystem::timer_thread() {
+    std::unique_lock<std::mutex> lock(_timer_mutex);
+    while (_running.load()) {
+        uint64_t now = timer_now_ms() / TIMER_TICK_MS;
+        if (_timer_next <= now) {
+            advance_timers(now);
+        }
+
+        if (_timer_count == 0) {
+            _timer_next = UINT64_MAX;
+            _timer_cv.wait(lock);
+        } else {
+            _timer_cv.wait_until(lock, _epoch + std::chrono::milliseconds(_timer_next * TIMER_TICK_MS));
+        }
+    }
+}
+
+CancelToken JobSystem::throttle_window(Throttle& throttle, uint32_t interval_ms, uint32_t& delay_ms) {
+    std::lock_guard<std::mutex> lock(_timer_mutex);
+    int64_t now = static_cast<int64_t>(timer_now_ms());
+    if (throttle.last_ms > now) {
+        delay_ms = static_cast<uint32_t>(throttle.last_ms - now);
+        return throttle.source.supersede();
+    }
+
+    int64_t start = now;
+    if (throttle.last_ms >= 0 && throttle.last_ms + interval_ms > now) {
+        start = throttle.last_ms + interval_ms;
+    }
+    throttle.last_ms = start;
+    delay_ms = static_cast<uint32_t>(start - now);
+    if (delay_ms == 0) {
+        return CancelToken();
+    }
+    return throttle.source.get_token();
+}
+
+void JobSystem::wake_one() {
+    if (_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(_sleep_mutex);
+        _wake_cv.notify_one();
+    }
+}
+
+void JobSystem::wake_io() {
+    if (_io_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(_io_mutex);
+        _io_cv.notify_one();
+    }
+}
+
+void JobSystem::sleep_until_work() {
+    std::unique_lock<std::mutex> lock(_sleep_mutex);
+    _sleepers.fetch_add(1);
+    _wake_cv.wait(lock, [this]() {
+        return !_running.load() || _queued.load() > 0;
+    });
+    _sleepers.fetch_sub(1);
+}
+
+bool JobSystem::find_job(uint32_t worker_id, uint32_t& slot) {
+    bool local = worker_id < _worker_count;
+    uint32_t start = local ? next_random(_workers[worker_id].seed) : 0;
+    bool found = false;
+
+    for (uint32_t p = PRIORITY_COUNT; p > 0 && !found; --p) {
+        found = (local && _workers[worker_id].deques[p - 1].pop(slot)) || _injected[p - 1].pop(slot);
+        for (uint32_t i = 0; i < _worker_count && !found; ++i) {
+            uint32_t victim = (start + i) % _worker_count;
+            found = victim != worker_id && _workers[victim].deques[p - 1].steal(slot);
+        }
+    }
+
+    if (found) {
+        _queued.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return found;
+}
+
+void JobSystem::run_job(uint32_t index) {
+    JobSlot& slot = slot_at(index);
+    Job* job = slot.job;
+    if (job->is_cancelled()) {
+        finish_job(index, JobState::Cancelled);
+        return;
+    }
+
+    uint32_t tracked = job->get_target() != JobTarget::MainThread ? 1 : 0;
+    if (!_profiling.load(std::memory_order_acquire)) {
+        t_active_depth += tracked;
+        job->set_state(JobState::Running);
+        job->execute();
+        t_active_depth -= tracked;
+        finish_job(index, JobState::Completed);
+        return;
+    }
+
+    const char* name = job->get_name();
+    uint64_t ready = slot.ready_ns;
+    uint64_t outer_ns = t_nested_ns;
+    t_nested_ns = 0;
+    uint64_t start = now_ns();
+    t_active_depth += tracked;
+    job->set_state(JobState::Running);
+    job->execute();
+    t_active_depth -= tracked;
+    uint64_t end = now_ns();
+    record_event(name, ready != 0 && ready < start ? ready : start, start, end, t_nested_ns);
+    t_nested_ns = outer_ns + (end - start);
+    finish_job(index, JobState::Completed);
+}
+
+void JobSystem::finish_job(uint32_t index, JobState state) {
+    JobSlot& slot = slot_at(index);
+    bool tracked = slot.job->get_target() != JobTarget::MainThread;
+    slot.job->set_state(state);
+    if (slot.pooled) {
+        slot.job->~Job();
+    } else {
+        delete slot.job;
+    }
+
+    slot.job = nullptr;
+    uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+    uint64_t head = slot.continuations.exchange((static_cast<uint64_t>(generation) << 32) | JobSlot::CLOSED_LINK, std::memory_order_acq_rel);
+    slot.generation.store(generation + 1, std::memory_order_release);
+    slot.generation.notify_all();
+    recycle_slot(index);
+
+    uint32_t link = static_cast<uint32_t>(head);
+    while (link != 0) {
+        uint32_t successor = (link - 1) / JobSlot::MAX_DEPENDENCIES;
+        uint32_t next = slot_at(successor).links[(link - 1) % JobSlot::MAX_DEPENDENCIES];
+        release_dependency(successor);
+        link = next;
+    }
+
+    if (!tracked) {
+        return;
+    }
+    _active.fetch_sub(1, std::memory_order_seq_cst);
+    if (_active_waiters.load(std::memory_order_seq_cst) > 0) {
+        _active.notify_all();
+        if (_main_waiters.load(std::memory_order_seq_cst) > 0) {
+            wake_main_thread();
+        }
+    }
 }
 
 void JobSystem::worker_thread(uint32_t worker_id) {
-    (void)worker_id;
+    t_system = this;
+    t_worker = worker_id;
+    t_lane_system = this;
+    t_lane = worker_id;
 
     while (_running.load()) {
-        Job* job = pop_job();
-        if (!job) {
+        uint32_t slot = 0;
+        if (find_job(worker_id, slot)) {
+            run_job(slot);
+        } else if (_queued.load() > 0) {
+            std::this_thread::yield();
+        } else {
+            sleep_until_work();
+        }
+    }
+
+    t_system = nullptr;
+    t_worker = MAX_WORKERS;
+    t_lane_system = nullptr;
+}
+
+void JobSystem::io_thread(uint32_t io_id) {
+    t_lane_system = this;
+    t_lane = _worker_count + io_id;
+
+    while (_running.load()) {
+        uint32_t slot = 0;
+        if (_io_queue.pop(slot)) {
+            _io_queued.fetch_sub(1, std::memory_order_acq_rel);
+            run_job(slot);
             continue;
         }
 
-        job->execute();
-        job->set_state(JobState::Completed);
+        std::unique_lock<std::mutex> lock(_io_mutex);
+        _io_sleepers.fetch_add(1);
+        _io_cv.wait(lock, [this]() {
+            return !_running.load() || _io_queued.load() > 0;
+        });
+        _io_sleepers.fetch_sub(1);
+    }
+
+    t_lane_system = nullptr;
+}
+
+uint32_t JobSystem::current_worker() const {
+    return t_system == this ? t_worker : MAX_WORKERS;
+}
 
-        delete job;
+bool JobSystem::is_main_thread() const {
+    return t_main_system == this && _running.load();
+}
+
+bool JobSystem::leads_to(uint32_t index, uint32_t target) const {
+    uint32_t stack[MAX_DEPENDENCY_STACK];
+    uint32_t count = 0;
+    uint32_t visited = 0;
+    stack[count++] = index;
+    while (count > 0) {
+        uint32_t current = stack[--count];
+        if (current == target || (target == UINT32_MAX && current != index && slot_at(current).job->get_target() != JobTarget::MainThread)) {
+            return true;
+        }
+        if (++visited >= MAX_DEPENDENCY_SCAN) {
+            return true;
+        }
+
+        uint32_t link = static_cast<uint32_t>(slot_at(current).continuations.load(std::memory_order_acquire));
+        while (link != 0 && link != JobSlot::CLOSED_LINK) {
+            uint32_t successor = (link - 1) / JobSlot::MAX_DEPENDENCIES;
+            if (count == MAX_DEPENDENCY_STACK) {
+                return true;
+            }
+            stack[count++] = successor;
+            link = slot_at(successor).links[(link - 1) % JobSlot::MAX_DEPENDENCIES];
+        }
+    }
+    return false;
+}
+
+bool JobSystem::take_main_dependency(uint32_t target, uint32_t& slot) {
+    collect_main_posted();
+    uint32_t prev = 0;
+    for (uint32_t link = _main_head; link != 0; link = slot_at(link - 1).next.load(std::memory_order_relaxed)) {
+        if (leads_to(link - 1, target)) {
+            uint32_t next = slot_at(link - 1).next.load(std::memory_order_relaxed);
+            if (prev != 0) {
+                slot_at(prev - 1).next.store(next, std::memory_order_relaxed);
+            } else {
+                _main_head = next;
+            }
+            if (_main_tail == link) {
+                _main_tail = prev;
+            }
+            slot = link - 1;
+            return true;
+        }
+        prev = link;
     }
+    return false;
+}
+
+void JobSystem::wait_on_main_thread(JobID id) {
+    _main_waiters.fetch_add(1, std::memory_order_seq_cst);
+    JobID wake = submit_lambda_after(&id, 1, [this]() {
+        wake_main_thread();
+    }, "WakeMainThread", JobPriority::Critical);
+
+    uint32_t target = static_cast<uint32_t>(id) - 1;
+    while (true) {
+        uint32_t signal = _main_wake.load(std::memory_order_seq_cst);
+        if (is_complete(id)) {
+            break;
+        }
+        uint32_t slot = 0;
+        if (take_main_dependency(target, slot) || find_job(current_worker(), slot)) {
+            run_job(slot);
+        } else if (wake != INVALID_JOB_ID) {
+            _main_wake.wait(signal, std::memory_order_seq_cst);
+        } else {
+            slot_at(target).generation.wait(static_cast<uint32_t>(id >> 32), std::memory_order_acquire);
+        }
+    }
+    _main_waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void JobSystem::wait_all_on_main_thread() {
+    _main_waiters.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        uint32_t signal = _main_wake.load(std::memory_order_seq_cst);
+        if (_active.load(std::memory_order_seq_cst) <= t_active_depth) {
+            break;
+        }
+        uint32_t slot = 0;
+        if (take_main_dependency(UINT32_MAX, slot) || find_job(current_worker(), slot)) {
+            run_job(slot);
+        } else {
+            _main_wake.wait(signal, std::memory_order_seq_cst);
+        }
+    }
+    _main_waiters.fetch_sub(1, std::memory_order_seq_cst);
 }
 
 void JobSystem::wait(JobID id) {
-    while (!is_complete(id) && _running.load()) {
-        std::this_thread::yield();
+    if (is_complete(id)) {
+        return;
+    }
+    if (is_main_thread()) {
+        wait_on_main_thread(id);
+        return;
+    }
+
+    uint32_t worker = current_worker();
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    while (!is_complete(id)) {
+        uint32_t slot = 0;
+        if (find_job(worker, slot)) {
+            run_job(slot);
+        } else {
+            slot_at(static_cast<uint32_t>(id) - 1).generation.wait(generation, std::memory_order_acquire);
+        }
     }
 }
 
 void JobSystem::wait_all() {
-    while (get_pending_count() > 0 && _running.load()) {
-        std::this_thread::yield();
+    _active_waiters.fetch_add(1, std::memory_order_seq_cst);
+    if (is_main_thread()) {
+        wait_all_on_main_thread();
+    } else {
+        uint32_t worker = current_worker();
+        uint32_t active = _active.load(std::memory_order_seq_cst);
+        while (active > t_active_depth) {
+            uint32_t slot = 0;
+            if (find_job(worker, slot)) {
+                run_job(slot);
+            } else {
+                _active.wait(active, std::memory_order_seq_cst);
+            }
+            active = _active.load(std::memory_order_seq_cst);
+        }
     }
+    _active_waiters.fetch_sub(1, std::memory_order_seq_cst);
 }
 
 bool JobSystem::is_complete(JobID id) const {
-    std::lock_guard<std::mutex> lock(_queue_mutex);
+    uint32_t index = static_cast<uint32_t>(id) - 1;
+    if (id == INVALID_JOB_ID || index / SLOT_PAGE_SIZE >= _slot_page_count.load(std::memory_order_acquire)) {
+        return true;
+    }
+    return slot_at(index).generation.load(std::memory_order_acquire) != static_cast<uint32_t>(id >> 32);
+}
+
+uint64_t JobSystem::now_ns() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count());
+}
+
+uint32_t JobSystem::current_lane() const {
+    return t_lane_system == this ? t_lane : _worker_count + _io_worker_count;
+}
+
+void JobSystem::record_event(const char* name, uint64_t ready_ns, uint64_t start_ns, uint64_t end_ns, uint64_t nested_ns) {
+    JobLaneStats& stats = _lane_stats[current_lane()];
+    stats.busy_ns.fetch_add(end_ns - start_ns - nested_ns, std::memory_order_relaxed);
+    stats.wait_ns.fetch_add(start_ns - ready_ns, std::memory_order_relaxed);
+    stats.jobs.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t sequence = _event_head.fetch_add(1, std::memory_order_relaxed);
+    JobEvent& event = _events[sequence & (EVENT_LOG_SIZE - 1)];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.ready_ns.store(ready_ns, std::memory_order_relaxed);
+    event.start_ns.store(start_ns, std::memory_order_relaxed);
+    event.end_ns.store(end_ns, std::memory_order_relaxed);
+    event.lane.store(current_lane(), std::memory_order_relaxed);
+    event.queued.store(_queued.load(std::memory_order_relaxed) + _io_queued.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    event.sequence.store(sequence + 1, std::memory_order_release);
+}
 
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        if (_pending_jobs[i].job && _pending_jobs[i].job->get_id() == id) {
-            return _pending_jobs[i].job->is_complete();
+void JobSystem::set_profiling(bool enabled) {
+    if (enabled == _profiling.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (!enabled) {
+        _profiling.store(false, std::memory_order_release);
+        return;
+    }
+
+    if (!_events) {
+        _events = new JobEvent[EVENT_LOG_SIZE];
+        for (uint32_t i = 0; i < EVENT_LOG_SIZE; ++i) {
+            _events[i].sequence.store(0, std::memory_order_relaxed);
         }
     }
+    for (uint32_t i = 0; i < MAX_LANES; ++i) {
+        _lane_stats[i].busy_ns.store(0, std::memory_order_relaxed);
+        _lane_stats[i].wait_ns.store(0, std::memory_order_relaxed);
+        _lane_stats[i].jobs.store(0, std::memory_order_relaxed);
+    }
+    _event_first = _event_head.load(std::memory_order_relaxed);
+    _profile_start_ns = now_ns();
+    _profiling.store(true, std::memory_order_release);
+}
 
-    return true;
+JobProfile JobSystem::get_profile() const {
+    JobProfile profile;
+    profile.worker_count = _worker_count;
+    profile.io_worker_count = _io_worker_count;
+    profile.elapsed_ns = _profile_start_ns != 0 ? now_ns() - _profile_start_ns : 0;
+    for (uint32_t i = 0; i < MAX_LANES; ++i) {
+        profile.lanes[i].busy_ns = _lane_stats[i].busy_ns.load(std::memory_order_relaxed);
+        profile.lanes[i].wait_ns = _lane_stats[i].wait_ns.load(std::memory_order_relaxed);
+        profile.lanes[i].jobs = _lane_stats[i].jobs.load(std::memory_order_relaxed);
+    }
+    return profile;
 }
 
-uint32_t JobSystem::get_pending_count() const {
-    std::lock_guard<std::mutex> lock(_queue_mutex);
-    return _pending_count;
+static void write_json_string(FILE* f, const char* text) {
+    fputc('"', f);
+    for (const char* c = text ? text : "Job"; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', f);
+            fputc(*c, f);
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            fprintf(f, "\\u%04x", static_cast<unsigned char>(*c));
+        } else {
+            fputc(*c, f);
+        }
+    }
+    fputc('"', f);
 }
 
-Job* JobSystem::find_job(JobID id) const {
-    for (uint32_t i = 0; i < MAX_PENDING_JOBS; ++i) {
-        if (_pending_jobs[i].job && _pending_jobs[i].job->get_id() == id) {
-            return _pending_jobs[i].job;
+bool JobSystem::export_chrome_trace(const char* path, uint32_t& event_count) const {
+    event_count = 0;
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    uint32_t lane_count = _worker_count + _io_worker_count + 1;
+    for (uint32_t lane = 0; lane < lane_count; ++lane) {
+        char name[32];
+        if (lane < _worker_count) {
+            snprintf(name, sizeof(name), "Worker %u", lane);
+        } else if (lane < _worker_count + _io_worker_count) {
+            snprintf(name, sizeof(name), "IO %u", lane - _worker_count);
+        } else {
+            snprintf(name, sizeof(name), "Main");
         }
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            lane == 0 ? "" : ",\n", lane, name);
     }
-    return nullptr;
+
+    if (_events) {
+        uint64_t head = _event_head.load(std::memory_order_acquire);
+        uint64_t first = head > _event_first + EVENT_LOG_SIZE ? head - EVENT_LOG_SIZE : _event_first;
+        for (uint64_t sequence = first; sequence < head; ++sequence) {
+            const JobEvent& event = _events[sequence & (EVENT_LOG_SIZE - 1)];
+            if (event.sequence.load(std::memory_order_acquire) != sequence + 1) {
+                continue;
+            }
+            const char* name = event.name.load(std::memory_order_relaxed);
+            uint64_t ready = event.ready_ns.load(std::memory_order_relaxed);
+            uint64_t start = event.start_ns.load(std::memory_order_relaxed);
+            uint64_t end = event.end_ns.load(std::memory_order_relaxed);
+            uint32_t lane = event.lane.load(std::memory_order_relaxed);
+            uint32_t queued = event.queued.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (event.sequence.load(std::memory_order_relaxed) != sequence + 1) {
+                continue;
+            }
+
+            fprintf(f, ",\n{\"name\":");
+            write_json_string(f, name);
+            fprintf(f, ",\"cat\":\"job\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"wait_us\":%.3f,\"queued\":%u}}",
+                lane, start / 1000.0, (end - start) / 1000.0, (start - ready) / 1000.0, queued);
+            fprintf(f, ",\n{\"name\":\"Queued jobs\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"queued\":%u}}",
+                start / 1000.0, queued);
+            ++event_count;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
 }
 
 }
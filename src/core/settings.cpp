@@ -13,7 +13,9 @@ Settings* Settings::get() {
 }
 
 Settings::Settings()
-    : _ui_scale(DEFAULT_UI_SCALE) {
+    : _ui_scale(DEFAULT_UI_SCALE)
+    , _undo_budget(DEFAULT_UNDO_BUDGET)
+    , _main_thread_budget_ms(DEFAULT_MAIN_THREAD_BUDGET_MS) {
 }
 
 Settings::~Settings() {
@@ -38,6 +40,14 @@ void Settings::reset_zoom() {
     set_ui_scale(DEFAULT_UI_SCALE);
 }
 
+void Settings::set_undo_budget(size_t bytes) {
+    _undo_budget = bytes < MIN_UNDO_BUDGET ? MIN_UNDO_BUDGET : bytes;
+}
+
+void Settings::set_main_thread_budget_ms(float budget_ms) {
+    _main_thread_budget_ms = budget_ms < MIN_MAIN_THREAD_BUDGET_MS ? MIN_MAIN_THREAD_BUDGET_MS : budget_ms;
+}
+
 void Settings::apply() {
     ImGuiIO& io = ImGui::GetIO();
     io.FontGlobalScale = _ui_scale;
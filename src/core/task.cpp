@@ -0,0 +1,56 @@
+#include "lunaris/core/task.h"
+#include <exception>
+
+namespace lunaris {
+
+std::coroutine_handle<> Task::FinalAwaiter::await_suspend(Handle handle) noexcept {
+    promise_type& promise = handle.promise();
+    if (promise.continuation) {
+        return promise.continuation;
+    }
+    if (promise.detached) {
+        handle.destroy();
+    }
+    return std::noop_coroutine();
+}
+
+void Task::promise_type::unhandled_exception() {
+    std::terminate();
+}
+
+Task::~Task() {
+    if (_handle) {
+        _handle.destroy();
+    }
+}
+
+void Task::start() {
+    if (!_handle) {
+        return;
+    }
+    Handle handle = _handle;
+    _handle = nullptr;
+    handle.promise().detached = true;
+    handle.resume();
+}
+
+std::coroutine_handle<> Task::await_suspend(std::coroutine_handle<> caller) noexcept {
+    _handle.promise().continuation = caller;
+    return _handle;
+}
+
+bool ResumeOn::await_suspend(std::coroutine_handle<> handle) {
+    JobID id = _jobs->submit_lambda_after(nullptr, 0, [handle]() {
+        handle.resume();
+    }, "ResumeTask", _priority, _target);
+    return id != INVALID_JOB_ID;
+}
+
+bool JobAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    JobID id = _jobs->submit_lambda_after(&_id, 1, [handle]() {
+        handle.resume();
+    }, "ResumeTask", JobPriority::Normal, _target);
+    return id != INVALID_JOB_ID;
+}
+
+}
@@ -0,0 +1,130 @@
+#include "lunaris/core/work_queue.h"
+
+namespace lunaris {
+
+static WorkRing* create_ring(int64_t capacity) {
+    WorkRing* ring = new WorkRing;
+    ring->items = new std::atomic<uint32_t>[capacity];
+    ring->mask = capacity - 1;
+    ring->retired = nullptr;
+    return ring;
+}
+
+WorkDeque::WorkDeque()
+    : _top(0)
+    , _bottom(0)
+    , _ring(create_ring(INITIAL_CAPACITY)) {
+}
+
+WorkDeque::~WorkDeque() {
+    WorkRing* ring = _ring.load(std::memory_order_relaxed);
+    while (ring) {
+        WorkRing* retired = ring->retired;
+        delete[] ring->items;
+        delete ring;
+        ring = retired;
+    }
+}
+
+WorkRing* WorkDeque::grow(WorkRing* ring, int64_t top, int64_t bottom) {
+    WorkRing* larger = create_ring((ring->mask + 1) * 2);
+    for (int64_t i = top; i < bottom; ++i) {
+        larger->items[i & larger->mask].store(ring->items[i & ring->mask].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    larger->retired = ring;
+    _ring.store(larger, std::memory_order_release);
+    return larger;
+}
+
+void WorkDeque::push(uint32_t item) {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    WorkRing* ring = _ring.load(std::memory_order_relaxed);
+    if (bottom - top > ring->mask) {
+        ring = grow(ring, top, bottom);
+    }
+    ring->items[bottom & ring->mask].store(item, std::memory_order_relaxed);
+    _bottom.store(bottom + 1, std::memory_order_release);
+}
+
+bool WorkDeque::pop(uint32_t& item) {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    WorkRing* ring = _ring.load(std::memory_order_relaxed);
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    item = ring->items[bottom & ring->mask].load(std::memory_order_relaxed);
+    if (top < bottom) {
+        return true;
+    }
+
+    bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+}
+
+bool WorkDeque::steal(uint32_t& item) {
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return false;
+    }
+
+    WorkRing* ring = _ring.load(std::memory_order_acquire);
+    item = ring->items[top & ring->mask].load(std::memory_order_relaxed);
+    return _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+InjectionQueue::InjectionQueue()
+    : _items(new uint32_t[INITIAL_CAPACITY])
+    , _head(0)
+    , _count(0)
+    , _capacity(INITIAL_CAPACITY)
+    , _size(0) {
+}
+
+InjectionQueue::~InjectionQueue() {
+    delete[] _items;
+}
+
+void InjectionQueue::push(uint32_t item) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count == _capacity) {
+        uint32_t* items = new uint32_t[_capacity * 2];
+        for (uint32_t i = 0; i < _count; ++i) {
+            items[i] = _items[(_head + i) % _capacity];
+        }
+        delete[] _items;
+        _items = items;
+        _head = 0;
+        _capacity *= 2;
+    }
+    _items[(_head + _count) % _capacity] = item;
+    ++_count;
+    _size.store(_count, std::memory_order_release);
+}
+
+bool InjectionQueue::pop(uint32_t& item) {
+    if (_size.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count == 0) {
+        return false;
+    }
+    item = _items[_head];
+    _head = (_head + 1) % _capacity;
+    --_count;
+    _size.store(_count, std::memory_order_release);
+    return true;
+}
+
+}
@@ -1,17 +1,20 @@
 #include "lunaris/editor/command_palette.h"
 #include "lunaris/core/command_registry.h"
 #include "lunaris/core/theme.h"
+#include "lunaris/editor/text_editor.h"
 #include "lunaris/ui/components.h"
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 
 namespace lunaris {
 
 CommandPalette::CommandPalette()
     : _registry(nullptr)
     , _theme(nullptr)
+    , _text_editor(nullptr)
     , _is_open(false)
     , _focus_input(false)
     , _result_count(0)
@@ -31,6 +34,12 @@ void CommandPalette::open() {
     update_search();
 }
 
+void CommandPalette::open_with(const char* text) {
+    open();
+    strncpy(_search_buffer, text, sizeof(_search_buffer) - 1);
+    update_search();
+}
+
 void CommandPalette::close() {
     _is_open = false;
     _focus_input = false;
@@ -45,7 +54,7 @@ void CommandPalette::toggle() {
 }
 
 void CommandPalette::update_search() {
-    if (!_registry) {
+    if (!_registry || is_line_query()) {
         _result_count = 0;
         return;
     }
@@ -57,6 +66,15 @@ void CommandPalette::update_search() {
 }
 
 void CommandPalette::execute_selected() {
+    if (is_line_query()) {
+        long line = strtol(_search_buffer + 1, nullptr, 10);
+        close();
+        if (_text_editor && line > 0) {
+            _text_editor->go_to_line(static_cast<uint32_t>(line - 1));
+        }
+        return;
+    }
+
     if (_result_count == 0 || !_registry) {
         return;
     }
@@ -143,9 +161,10 @@ void CommandPalette::draw_input() {
         _focus_input = false;
     }
 
-    bool changed = ImGui::InputTextWithHint("##palette_input", "Type a command...", 
+    ImGuiInputTextFlags input_flags = is_line_query() ? 0 : ImGuiInputTextFlags_AutoSelectAll;
+    bool changed = ImGui::InputTextWithHint("##palette_input", "Type a command, or : and a line number...", 
                                             _search_buffer, sizeof(_search_buffer),
-                                            ImGuiInputTextFlags_AutoSelectAll);
+                                            input_flags);
     if (changed) {
         update_search();
         _selected_index = 0;
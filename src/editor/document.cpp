@@ -9,6 +9,7 @@ static uint32_t s_untitled_counter = 0;
 Document::Document()
     : _id(INVALID_DOCUMENT_ID)
     , _tab_id(INVALID_TAB_ID)
+    , _path_id(INVALID_PATH_ID)
     , _type(DocumentType::PlainText)
     , _cursor_pos(0)
     , _selection_start(0)
@@ -23,8 +24,8 @@ Document::~Document() {
     close();
 }
 
-bool Document::open(const char* filepath) {
-    if (!_buffer.load_from_file(filepath)) {
+bool Document::open(const char* filepath, JobSystem* jobs) {
+    if (!_buffer.load_from_file(filepath, jobs)) {
         return false;
     }
 
@@ -45,6 +46,19 @@ bool Document::open(const char* filepath) {
     return true;
 }
 
+bool Document::reload(JobSystem* jobs) {
+    if (!has_file() || !_buffer.load_from_file(_filepath, jobs)) {
+        return false;
+    }
+
+    _buffer.clear_history();
+    size_t length = _buffer.get_length();
+    if (_cursor_pos > length) _cursor_pos = length;
+    if (_selection_start > length) _selection_start = length;
+    if (_selection_end > length) _selection_end = length;
+    return true;
+}
+
 bool Document::save() {
     if (!has_file()) {
         return false;
@@ -2,7 +2,6 @@
 #include "lunaris/editor/tab_bar.h"
 #include "lunaris/editor/undo_manager.h"
 #include <tinyvk/core/file_dialog.h>
-#include <cstring>
 
 namespace lunaris {
 
@@ -11,14 +10,20 @@ DocumentManager::DocumentManager()
     , _active_id(INVALID_DOCUMENT_ID)
     , _next_id(1)
     , _tab_bar(nullptr)
-    , _theme(nullptr) {
+    , _theme(nullptr)
+    , _job_system(nullptr) {
     for (uint32_t i = 0; i < MAX_DOCUMENTS; ++i) {
         _documents[i] = nullptr;
     }
+    UndoManager::instance().set_path_table(&_paths);
 }
 
 DocumentManager::~DocumentManager() {
+    UndoManager::instance().clear();
+    UndoManager::instance().set_path_table(nullptr);
     for (uint32_t i = 0; i < _document_count; ++i) {
+        _undo_store.detach_buffer(_documents[i]->get_buffer());
+        _paths.release(_documents[i]->get_path_id());
         delete _documents[i];
         _documents[i] = nullptr;
     }
@@ -70,13 +75,16 @@ DocumentID DocumentManager::open_document(const char* filepath) {
     }
 
     Document* doc = new Document();
-    if (!doc->open(filepath)) {
+    if (!doc->open(filepath, _job_system)) {
         delete doc;
         return INVALID_DOCUMENT_ID;
     }
 
+    _undo_store.restore(doc->get_filepath(), doc->get_buffer());
+
     DocumentID id = generate_id();
     doc->set_id(id);
+    doc->set_path_id(_paths.intern(doc->get_filepath()));
 
     if (_tab_bar) {
         TabInfo tab_info;
@@ -107,6 +115,7 @@ bool DocumentManager::save_document(DocumentID id) {
 
     bool result = doc->save();
     if (result) {
+        _undo_store.save(doc->get_filepath(), doc->get_buffer());
         sync_tab_modified(id);
     }
     return result;
@@ -119,6 +128,16 @@ bool DocumentManager::save_document_as(DocumentID id, const char* filepath) {
     }
 
     bool result = doc->save_as(filepath);
+    if (result) {
+        PathID path_id = _paths.intern(doc->get_filepath());
+        if (path_id != doc->get_path_id()) {
+            _undo_store.save_as(doc->get_filepath(), doc->get_buffer());
+        } else {
+            _undo_store.save(doc->get_filepath(), doc->get_buffer());
+        }
+        _paths.release(doc->get_path_id());
+        doc->set_path_id(path_id);
+    }
     if (result && _tab_bar) {
         _tab_bar->set_tab_title(doc->get_tab_id(), doc->get_title());
         sync_tab_modified(id);
@@ -147,9 +166,10 @@ void DocumentManager::close_document(DocumentID id) {
         return;
     }
 
-    UndoManager::instance().clear_for_document(id);
-
     Document* doc = _documents[index];
+    _undo_store.detach_buffer(doc->get_buffer());
+    _paths.release(doc->get_path_id());
+
     TabID closing_tab = doc->get_tab_id();
 
     if (_tab_bar) {
@@ -218,8 +238,12 @@ const Document* DocumentManager::get_document(DocumentID id) const {
 }
 
 Document* DocumentManager::find_by_path(const char* filepath) {
+    PathID path_id = _paths.find(filepath);
+    if (path_id == INVALID_PATH_ID) {
+        return nullptr;
+    }
     for (uint32_t i = 0; i < _document_count; ++i) {
-        if (_documents[i] && strcmp(_documents[i]->get_filepath(), filepath) == 0) {
+        if (_documents[i] && _documents[i]->get_path_id() == path_id) {
             return _documents[i];
         }
     }
@@ -290,6 +314,47 @@ void DocumentManager::save_file_dialog() {
     }
 }
 
+uint32_t DocumentManager::poll_file_changes() {
+    uint32_t truncated = 0;
+    for (uint32_t i = 0; i < _document_count; ++i) {
+        Document* doc = _documents[i];
+        if (!doc->has_file()) {
+            continue;
+        }
+
+        TextBuffer* buffer = doc->get_buffer();
+        FileChange change = buffer->check_backing_file(doc->get_filepath());
+        if (change == FileChange::None) {
+            continue;
+        }
+
+        if (change == FileChange::Removed) {
+            buffer->set_modified(true);
+        } else if ((doc->is_modified() || !doc->reload(_job_system)) && change == FileChange::Modified
+            && buffer->detach_backing_file()) {
+            ++truncated;
+        }
+        sync_tab_modified(doc->get_id());
+    }
+    return truncated;
+}
+
+bool DocumentManager::poll_indexing(float& progress) {
+    uint32_t indexing = 0;
+    float total = 0.0f;
+    for (uint32_t i = 0; i < _document_count; ++i) {
+        TextBuffer* buffer = _documents[i]->get_buffer();
+        if (!buffer->is_indexing() || buffer->finish_indexing()) {
+            continue;
+        }
+        total += buffer->get_index_progress();
+        ++indexing;
+    }
+
+    progress = indexing > 0 ? total / static_cast<float>(indexing) : 1.0f;
+    return indexing > 0;
+}
+
 void DocumentManager::sync_tab_modified(DocumentID id) {
     Document* doc = get_document(id);
     if (doc && _tab_bar) {
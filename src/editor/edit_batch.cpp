@@ -0,0 +1,115 @@
+#include "lunaris/editor/edit_batch.h"
+#include "lunaris/editor/piece_tree.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lunaris {
+
+EditBatch::EditBatch()
+    : _edits(nullptr)
+    , _count(0)
+    , _capacity(0)
+    , _text(nullptr)
+    , _text_length(0)
+    , _text_capacity(0) {
+}
+
+EditBatch::~EditBatch() {
+    delete[] _edits;
+    delete[] _text;
+}
+
+char* EditBatch::reserve_text(size_t len) {
+    if (_text_length + len > _text_capacity) {
+        size_t new_cap = _text_capacity == 0 ? 256 : _text_capacity * 2;
+        while (new_cap < _text_length + len) {
+            new_cap *= 2;
+        }
+        char* new_text = new char[new_cap];
+        if (_text) {
+            memcpy(new_text, _text, _text_length);
+        }
+        delete[] _text;
+        _text = new_text;
+        _text_capacity = new_cap;
+    }
+    char* out = _text + _text_length;
+    _text_length += len;
+    return out;
+}
+
+void EditBatch::add(size_t pos, size_t removed, const char* text, size_t len) {
+    if (removed == 0 && len == 0) return;
+
+    if (_count >= _capacity) {
+        uint32_t new_cap = _capacity == 0 ? 16 : _capacity * 2;
+        BatchEdit* new_edits = new BatchEdit[new_cap];
+        if (_edits) {
+            memcpy(new_edits, _edits, _count * sizeof(BatchEdit));
+        }
+        delete[] _edits;
+        _edits = new_edits;
+        _capacity = new_cap;
+    }
+
+    BatchEdit& edit = _edits[_count++];
+    edit.pos = pos;
+    edit.removed = removed;
+    edit.inserted = len;
+    edit.removed_offset = 0;
+    edit.inserted_offset = _text_length;
+    if (len > 0) {
+        memcpy(reserve_text(len), text, len);
+    }
+}
+
+bool EditBatch::prepare(const PieceView& view) {
+    std::stable_sort(_edits, _edits + _count, [](const BatchEdit& a, const BatchEdit& b) {
+        return a.pos < b.pos;
+    });
+
+    size_t length = view.get_length();
+    size_t end = 0;
+    for (uint32_t i = 0; i < _count; ++i) {
+        BatchEdit& edit = _edits[i];
+        if (edit.pos < end || edit.pos + edit.removed > length) {
+            return false;
+        }
+        end = edit.pos + edit.removed;
+    }
+
+    for (uint32_t i = 0; i < _count; ++i) {
+        BatchEdit& edit = _edits[i];
+        edit.removed_offset = _text_length;
+        if (edit.removed > 0) {
+            view.copy_range(edit.pos, edit.removed, reserve_text(edit.removed));
+        }
+    }
+    return true;
+}
+
+EditBatch* EditBatch::clone() const {
+    EditBatch* copy = new EditBatch();
+    copy->assign(_edits, _count, _text, _text_length);
+    return copy;
+}
+
+void EditBatch::assign(const BatchEdit* edits, uint32_t count, const char* text, size_t text_size) {
+    delete[] _edits;
+    delete[] _text;
+    _edits = new BatchEdit[count > 0 ? count : 1];
+    _count = count;
+    _capacity = count;
+    memcpy(_edits, edits, count * sizeof(BatchEdit));
+    _text = new char[text_size > 0 ? text_size : 1];
+    _text_length = text_size;
+    _text_capacity = text_size;
+    memcpy(_text, text, text_size);
+}
+
+void EditBatch::clear() {
+    _count = 0;
+    _text_length = 0;
+}
+
+}
@@ -0,0 +1,32 @@
+#include "lunaris/editor/edit_journal.h"
+
+namespace lunaris {
+
+EditJournal::EditJournal()
+    : _head(0) {
+}
+
+void EditJournal::record(size_t pos, size_t removed, size_t inserted, uint32_t version) {
+    EditDelta& delta = _deltas[_head % CAPACITY];
+    delta.pos = pos;
+    delta.removed = removed;
+    delta.inserted = inserted;
+    delta.version = version;
+    ++_head;
+}
+
+bool EditJournal::read(uint64_t& cursor, EditDelta* out, uint32_t max, uint32_t& count) const {
+    count = 0;
+    if (!is_valid(cursor)) {
+        cursor = _head;
+        return false;
+    }
+
+    while (cursor < _head && count < max) {
+        out[count++] = _deltas[cursor % CAPACITY];
+        ++cursor;
+    }
+    return true;
+}
+
+}
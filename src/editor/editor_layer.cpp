@@ -19,6 +19,8 @@
 #include "lunaris/ui/components.h"
 #include <imgui.h>
 #include <imgui_internal.h>
+#include <cstdio>
+#include <filesystem>
 
 namespace lunaris {
 
@@ -40,6 +42,7 @@ EditorLayer::EditorLayer()
     , _document_manager(nullptr)
     , _text_editor(nullptr)
     , _file_operations(nullptr)
+    , _indexing_visible(false)
     , _first_frame(true) {
     s_instance = this;
 }
@@ -106,13 +109,16 @@ void EditorLayer::on_init() {
     _status_bar->set_plugin_manager(_plugin_manager);
     _command_palette->set_command_registry(_command_registry);
     _command_palette->set_theme(_theme);
+    _command_palette->set_text_editor(_text_editor);
     _document_manager->set_tab_bar(_tab_bar);
     _document_manager->set_theme(_theme);
+    _document_manager->set_job_system(_job_system);
     _text_editor->set_theme(_theme);
     _text_editor->set_document_manager(_document_manager);
     _text_editor->set_file_operations(_file_operations);
     _file_operations->set_document_manager(_document_manager);
     _file_operations->set_sidebar(_sidebar);
+    _file_operations->set_job_system(_job_system);
 
     register_builtin_commands();
 
@@ -124,6 +130,8 @@ void EditorLayer::on_init() {
     _bottom_panel->on_init();
     _workspace->on_init();
     _status_bar->on_init();
+
+    schedule_file_poll();
 }
 
 void EditorLayer::on_shutdown() {
@@ -214,6 +222,10 @@ void EditorLayer::on_shutdown() {
 }
 
 void EditorLayer::on_update(float delta_time) {
+    if (_job_system) {
+        _job_system->drain_main_thread(Settings::get()->get_main_thread_budget_ms());
+    }
+
     if (_plugin_manager) {
         _plugin_manager->update_all(delta_time);
     }
@@ -221,6 +233,28 @@ void EditorLayer::on_update(float delta_time) {
     if (_workspace) {
         _workspace->on_update(delta_time);
     }
+
+    if (_document_manager && _sidebar) {
+        _document_manager->set_workspace(_sidebar->get_folder_path());
+    }
+
+    float progress = 0.0f;
+    if (_document_manager && _document_manager->poll_indexing(progress)) {
+        _status_bar->set_progress(progress, "Indexing lines, read-only");
+        _indexing_visible = true;
+    } else if (_indexing_visible) {
+        _status_bar->clear_progress();
+        _indexing_visible = false;
+    }
+}
+
+void EditorLayer::schedule_file_poll() {
+    _job_system->submit_delayed(FILE_POLL_INTERVAL_MS, [this]() {
+        if (_document_manager && _document_manager->poll_file_changes() > 0) {
+            _status_bar->set_status_text("File truncated on disk, its missing tail was dropped from the editor");
+        }
+        schedule_file_poll();
+    }, "PollFileChanges", JobPriority::Low, JobTarget::MainThread);
 }
 
 void EditorLayer::on_ui() {
@@ -254,6 +288,12 @@ void EditorLayer::handle_keyboard_shortcuts() {
         }
     }
 
+    if (ctrl && ImGui::IsKeyPressed(ImGuiKey_G, false)) {
+        if (_command_palette && !_command_palette->is_open()) {
+            _command_palette->open_with(":");
+        }
+    }
+
     if (ctrl && ImGui::IsKeyPressed(ImGuiKey_N, false)) {
         new_file();
     }
@@ -414,6 +454,28 @@ void EditorLayer::register_builtin_commands() {
     cmd_quit.category = CommandCategory::General;
     _command_registry->register_command(cmd_quit, [](void*) {}, nullptr);
 
+    CommandInfo cmd_undo_files;
+    cmd_undo_files.name = "Undo Across Files";
+    cmd_undo_files.description = "Undo the most recent edit or file operation in any document";
+    cmd_undo_files.shortcut = "Ctrl+Alt+Z";
+    cmd_undo_files.category = CommandCategory::Edit;
+    _command_registry->register_command(cmd_undo_files, [](void*) {
+        if (s_instance && s_instance->_text_editor) {
+            s_instance->_text_editor->undo_across_files();
+        }
+    }, nullptr);
+
+    CommandInfo cmd_redo_files;
+    cmd_redo_files.name = "Redo Across Files";
+    cmd_redo_files.description = "Redo the most recently undone edit or file operation in any document";
+    cmd_redo_files.shortcut = "Ctrl+Alt+Shift+Z";
+    cmd_redo_files.category = CommandCategory::Edit;
+    _command_registry->register_command(cmd_redo_files, [](void*) {
+        if (s_instance && s_instance->_text_editor) {
+            s_instance->_text_editor->redo_across_files();
+        }
+    }, nullptr);
+
     CommandInfo cmd_find;
     cmd_find.name = "Find";
     cmd_find.description = "Find in current file";
@@ -426,7 +488,11 @@ void EditorLayer::register_builtin_commands() {
     cmd_goto_line.description = "Jump to a specific line number";
     cmd_goto_line.shortcut = "Ctrl+G";
     cmd_goto_line.category = CommandCategory::Navigation;
-    _command_registry->register_command(cmd_goto_line, [](void*) {}, nullptr);
+    _command_registry->register_command(cmd_goto_line, [](void*) {
+        if (s_instance && s_instance->_command_palette) {
+            s_instance->_command_palette->open_with(":");
+        }
+    }, nullptr);
 
     CommandInfo cmd_zoom_in;
     cmd_zoom_in.name = "Zoom In";
@@ -454,6 +520,64 @@ void EditorLayer::register_builtin_commands() {
     _command_registry->register_command(cmd_reset_zoom, [](void*) {
         Settings::get()->reset_zoom();
     }, nullptr);
+
+    CommandInfo cmd_toggle_profiling;
+    cmd_toggle_profiling.name = "Toggle Job Profiling";
+    cmd_toggle_profiling.description = "Start or stop recording job timings and worker utilization";
+    cmd_toggle_profiling.shortcut = nullptr;
+    cmd_toggle_profiling.category = CommandCategory::Debug;
+    _command_registry->register_command(cmd_toggle_profiling, [](void*) {
+        if (!s_instance || !s_instance->_job_system || !s_instance->_status_bar) {
+            return;
+        }
+        JobSystem* jobs = s_instance->_job_system;
+        jobs->set_profiling(!jobs->is_profiling());
+        s_instance->_status_bar->set_status_text(jobs->is_profiling() ? "Job profiling started" : "Job profiling stopped");
+    }, nullptr);
+
+    CommandInfo cmd_export_trace;
+    cmd_export_trace.name = "Export Job Trace";
+    cmd_export_trace.description = "Write recorded job events as Chrome trace JSON";
+    cmd_export_trace.shortcut = nullptr;
+    cmd_export_trace.category = CommandCategory::Debug;
+    _command_registry->register_command(cmd_export_trace, [](void*) {
+        if (!s_instance || !s_instance->_job_system || !s_instance->_status_bar) {
+            return;
+        }
+        JobSystem* jobs = s_instance->_job_system;
+        if (!jobs->is_profiling()) {
+            s_instance->_status_bar->set_status_text("Job profiling is off, run Toggle Job Profiling first");
+            return;
+        }
+
+        char path[1024];
+        const char* folder = s_instance->_sidebar ? s_instance->_sidebar->get_folder_path() : nullptr;
+        if (folder && folder[0] != '\0') {
+            snprintf(path, sizeof(path), "%s/.lunaris", folder);
+            std::error_code ec;
+            std::filesystem::create_directories(path, ec);
+            snprintf(path, sizeof(path), "%s/.lunaris/job-trace.json", folder);
+        } else {
+            snprintf(path, sizeof(path), "lunaris-job-trace.json");
+        }
+
+        uint32_t events = 0;
+        char status[256];
+        if (!jobs->export_chrome_trace(path, events)) {
+            snprintf(status, sizeof(status), "Failed to write job trace to %s", path);
+            s_instance->_status_bar->set_status_text(status);
+            return;
+        }
+
+        JobProfile profile = jobs->get_profile();
+        int length = snprintf(status, sizeof(status), "Job trace: %u events in %s, busy", events, path);
+        double elapsed = profile.elapsed_ns > 0 ? static_cast<double>(profile.elapsed_ns) : 1.0;
+        for (uint32_t i = 0; i < profile.worker_count && length > 0 && static_cast<size_t>(length) < sizeof(status); ++i) {
+            length += snprintf(status + length, sizeof(status) - length, " %.0f%%",
+                100.0 * static_cast<double>(profile.lanes[i].busy_ns) / elapsed);
+        }
+        s_instance->_status_bar->set_status_text(status);
+    }, nullptr);
 }
 
 void EditorLayer::setup_layout() {
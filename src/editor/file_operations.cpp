@@ -2,6 +2,8 @@
 #include "lunaris/editor/undo_manager.h"
 #include "lunaris/editor/document_manager.h"
 #include "lunaris/editor/sidebar.h"
+#include "lunaris/core/async_file.h"
+#include "lunaris/core/task.h"
 #include <cstdio>
 #include <cstring>
 #include <sys/stat.h>
@@ -12,10 +14,15 @@ namespace lunaris {
 
 FileOperations::FileOperations()
     : _doc_manager(nullptr)
-    , _sidebar(nullptr) {
+    , _sidebar(nullptr)
+    , _job_system(nullptr)
+    , _copies(nullptr) {
 }
 
 FileOperations::~FileOperations() {
+    for (PendingCopy* copy = _copies; copy; copy = copy->next) {
+        copy->owner = nullptr;
+    }
 }
 
 bool FileOperations::file_exists(const char* path) const {
@@ -30,43 +37,6 @@ bool FileOperations::folder_exists(const char* path) const {
     return S_ISDIR(st.st_mode);
 }
 
-bool FileOperations::read_file_content(const char* path, char** out_content, size_t* out_len) const {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        *out_content = nullptr;
-        *out_len = 0;
-        return false;
-    }
-
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    if (size < 0 || static_cast<size_t>(size) > MAX_CONTENT_LEN) {
-        fclose(f);
-        *out_content = nullptr;
-        *out_len = 0;
-        return false;
-    }
-
-    char* content = new char[size + 1];
-    size_t read = fread(content, 1, size, f);
-    content[read] = '\0';
-    fclose(f);
-
-    *out_content = content;
-    *out_len = read;
-    return true;
-}
-
-bool FileOperations::write_file(const char* path, const char* content, size_t len) {
-    FILE* f = fopen(path, "wb");
-    if (!f) return false;
-    size_t written = fwrite(content, 1, len, f);
-    fclose(f);
-    return written == len;
-}
-
 bool FileOperations::remove_file(const char* path) {
     return unlink(path) == 0;
 }
@@ -131,9 +101,16 @@ bool FileOperations::create_file(const char* path) {
 bool FileOperations::delete_file(const char* path) {
     if (!file_exists(path)) return false;
 
-    char* content = nullptr;
+    struct stat st;
+    if (stat(path, &st) != 0 || static_cast<uint64_t>(st.st_size) > MAX_CONTENT_LEN) return false;
+
     size_t content_len = 0;
-    read_file_content(path, &content, &content_len);
+    char* content = read_whole_file(path, content_len);
+    if (!content) return false;
+    if (content_len != static_cast<size_t>(st.st_size)) {
+        delete[] content;
+        return false;
+    }
 
     if (_doc_manager) {
         Document* doc = _doc_manager->find_by_path(path);
@@ -178,24 +155,54 @@ bool FileOperations::duplicate_file(const char* path) {
     char new_path[MAX_PATH_LEN];
     get_duplicate_path(path, new_path, sizeof(new_path));
 
-    char* content = nullptr;
-    size_t content_len = 0;
-    if (!read_file_content(path, &content, &content_len)) {
-        return false;
-    }
+    FILE* f = fopen(new_path, "wb");
+    if (!f) return false;
+    fclose(f);
 
-    bool ok = write_file(new_path, content, content_len);
-    delete[] content;
+    PendingCopy* copy = new PendingCopy();
+    copy->owner = this;
+    copy->next = _copies;
+    memcpy(copy->target, new_path, strlen(new_path) + 1);
+    _copies = copy;
 
-    if (!ok) return false;
+    copy_file(_job_system, copy, path).start();
+    return true;
+}
 
-    UndoManager::instance().record_file_create(new_path);
+Task FileOperations::copy_file(JobSystem* jobs, PendingCopy* copy, const char* path) {
+    FileReadResult content = co_await read_file_async(jobs, path, JobTarget::MainThread);
 
-    if (_sidebar) {
-        _sidebar->refresh_file_tree();
+    bool written = false;
+    if (content.data && copy->owner) {
+        written = co_await write_file_async(jobs, copy->target, content.data, content.length, JobTarget::MainThread);
     }
+    delete[] content.data;
 
-    return true;
+    if (!written) {
+        remove_file(copy->target);
+    }
+    if (copy->owner) {
+        copy->owner->finish_copy(copy, written);
+    } else {
+        delete copy;
+    }
+}
+
+void FileOperations::finish_copy(PendingCopy* copy, bool written) {
+    PendingCopy** link = &_copies;
+    while (*link != copy) {
+        link = &(*link)->next;
+    }
+    *link = copy->next;
+
+    if (written) {
+        UndoManager::instance().record_file_create(copy->target);
+
+        if (_sidebar) {
+            _sidebar->refresh_file_tree();
+        }
+    }
+    delete copy;
 }
 
 bool FileOperations::create_folder(const char* path) {
@@ -242,23 +249,27 @@ bool FileOperations::rename_folder(const char* old_path, const char* new_path) {
 }
 
 bool FileOperations::apply_undo(const UndoAction* action) {
-    if (!action) return false;
+    if (!action || !_doc_manager) return false;
+
+    const PathTable& paths = _doc_manager->get_paths();
+    const char* path = paths.get(action->path);
+    const char* path_alt = paths.get(action->path_alt);
 
     switch (action->type) {
         case UndoActionType::FileCreate:
-            if (file_exists(action->path)) {
-                remove_file(action->path);
+            if (file_exists(path)) {
+                remove_file(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FileDelete:
-            if (!file_exists(action->path)) {
+            if (!file_exists(path)) {
                 if (action->content && action->content_len > 0) {
-                    write_file(action->path, action->content, action->content_len);
+                    write_whole_file(path, action->content, action->content_len);
                 } else {
-                    FILE* f = fopen(action->path, "wb");
+                    FILE* f = fopen(path, "wb");
                     if (f) fclose(f);
                 }
                 if (_sidebar) _sidebar->refresh_file_tree();
@@ -267,32 +278,32 @@ bool FileOperations::apply_undo(const UndoAction* action) {
             break;
 
         case UndoActionType::FileRename:
-            if (file_exists(action->path_alt)) {
-                rename_path(action->path_alt, action->path);
+            if (file_exists(path_alt)) {
+                rename_path(path_alt, path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderCreate:
-            if (folder_exists(action->path)) {
-                remove_directory(action->path);
+            if (folder_exists(path)) {
+                remove_directory(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderDelete:
-            if (!folder_exists(action->path)) {
-                make_directory(action->path);
+            if (!folder_exists(path)) {
+                make_directory(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderRename:
-            if (folder_exists(action->path_alt)) {
-                rename_path(action->path_alt, action->path);
+            if (folder_exists(path_alt)) {
+                rename_path(path_alt, path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
@@ -305,12 +316,16 @@ bool FileOperations::apply_undo(const UndoAction* action) {
 }
 
 bool FileOperations::apply_redo(const UndoAction* action) {
-    if (!action) return false;
+    if (!action || !_doc_manager) return false;
+
+    const PathTable& paths = _doc_manager->get_paths();
+    const char* path = paths.get(action->path);
+    const char* path_alt = paths.get(action->path_alt);
 
     switch (action->type) {
         case UndoActionType::FileCreate:
-            if (!file_exists(action->path)) {
-                FILE* f = fopen(action->path, "wb");
+            if (!file_exists(path)) {
+                FILE* f = fopen(path, "wb");
                 if (f) fclose(f);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
@@ -318,46 +333,44 @@ bool FileOperations::apply_redo(const UndoAction* action) {
             break;
 
         case UndoActionType::FileDelete:
-            if (file_exists(action->path)) {
-                if (_doc_manager) {
-                    Document* doc = _doc_manager->find_by_path(action->path);
-                    if (doc) {
-                        _doc_manager->close_document(doc->get_id());
-                    }
+            if (file_exists(path)) {
+                Document* doc = _doc_manager->find_by_path(path);
+                if (doc) {
+                    _doc_manager->close_document(doc->get_id());
                 }
-                remove_file(action->path);
+                remove_file(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FileRename:
-            if (file_exists(action->path)) {
-                rename_path(action->path, action->path_alt);
+            if (file_exists(path)) {
+                rename_path(path, path_alt);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderCreate:
-            if (!folder_exists(action->path)) {
-                make_directory(action->path);
+            if (!folder_exists(path)) {
+                make_directory(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderDelete:
-            if (folder_exists(action->path)) {
-                remove_directory(action->path);
+            if (folder_exists(path)) {
+                remove_directory(path);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
             break;
 
         case UndoActionType::FolderRename:
-            if (folder_exists(action->path)) {
-                rename_path(action->path, action->path_alt);
+            if (folder_exists(path)) {
+                rename_path(path, path_alt);
                 if (_sidebar) _sidebar->refresh_file_tree();
                 return true;
             }
@@ -0,0 +1,360 @@
+#include "lunaris/editor/mapped_file.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <csignal>
+    #include <cstring>
+    #include <atomic>
+#endif
+
+namespace lunaris {
+
+MappedFile::MappedFile()
+#ifdef _WIN32
+    : _file(nullptr)
+    , _mapping(nullptr)
+    , _write_time(0)
+#else
+    : _fd(-1)
+    , _guard(MAX_GUARDED_MAPPINGS)
+    , _mtime(0)
+    , _device(0)
+    , _inode(0)
+    , _path_device(0)
+    , _path_inode(0)
+#endif
+    , _data(nullptr)
+    , _size(0)
+    , _open(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+static uint64_t get_write_time(HANDLE file) {
+    FILETIME write_time;
+    if (!GetFileTime(file, nullptr, nullptr, &write_time)) {
+        return 0;
+    }
+    return (static_cast<uint64_t>(write_time.dwHighDateTime) << 32) | write_time.dwLowDateTime;
+}
+
+bool MappedFile::open(const char* path, bool shared_write) {
+    close();
+
+    DWORD share = shared_write ? FILE_SHARE_READ | FILE_SHARE_WRITE : FILE_SHARE_READ;
+    HANDLE file = CreateFileA(path, GENERIC_READ, share, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || GetFileType(file) != FILE_TYPE_DISK) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = nullptr;
+    const char* data = nullptr;
+    if (size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!data) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+    }
+
+    _file = file;
+    _mapping = mapping;
+    _write_time = get_write_time(file);
+    _data = data;
+    _size = static_cast<size_t>(size.QuadPart);
+    _open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+        CloseHandle(static_cast<HANDLE>(_mapping));
+    }
+    if (_file) {
+        CloseHandle(static_cast<HANDLE>(_file));
+    }
+    _file = nullptr;
+    _mapping = nullptr;
+    _write_time = 0;
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+bool MappedFile::is_same_file(const char* path) const {
+    if (!_open) {
+        return false;
+    }
+
+    HANDLE other = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (other == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION mapped_info;
+    BY_HANDLE_FILE_INFORMATION other_info;
+    bool same = GetFileInformationByHandle(static_cast<HANDLE>(_file), &mapped_info)
+        && GetFileInformationByHandle(other, &other_info)
+        && mapped_info.dwVolumeSerialNumber == other_info.dwVolumeSerialNumber
+        && mapped_info.nFileIndexHigh == other_info.nFileIndexHigh
+        && mapped_info.nFileIndexLow == other_info.nFileIndexLow;
+    CloseHandle(other);
+    return same;
+}
+
+FileChange MappedFile::check_changes(const char* path) const {
+    if (!_open) {
+        return FileChange::None;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(static_cast<HANDLE>(_file), &size)
+        && (static_cast<size_t>(size.QuadPart) != _size || get_write_time(static_cast<HANDLE>(_file)) != _write_time)) {
+        return FileChange::Modified;
+    }
+
+    if (GetFileAttributesA(path) == INVALID_FILE_ATTRIBUTES) {
+        return FileChange::Removed;
+    }
+    if (!is_same_file(path)) {
+        return FileChange::Replaced;
+    }
+    return FileChange::None;
+}
+
+size_t MappedFile::get_readable_size() const {
+    LARGE_INTEGER size;
+    if (!_open || !GetFileSizeEx(static_cast<HANDLE>(_file), &size)) {
+        return 0;
+    }
+    return static_cast<size_t>(size.QuadPart) < _size ? static_cast<size_t>(size.QuadPart) : _size;
+}
+
+void MappedFile::track_path(const char* path) {
+    (void)path;
+}
+
+#else
+
+struct GuardedRange {
+    std::atomic<uintptr_t> begin;
+    std::atomic<uintptr_t> end;
+    std::atomic<uintptr_t> faulted;
+};
+
+static GuardedRange s_guarded[MappedFile::MAX_GUARDED_MAPPINGS];
+static struct sigaction s_previous_bus_action;
+static uintptr_t s_page_size = 0;
+
+static void on_bus_error(int signal_number, siginfo_t* info, void* context) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(info->si_addr);
+    for (uint32_t i = 0; i < MappedFile::MAX_GUARDED_MAPPINGS; ++i) {
+        GuardedRange& range = s_guarded[i];
+        uintptr_t begin = range.begin.load(std::memory_order_acquire);
+        if (begin == 0 || address < begin || address >= range.end.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        uintptr_t page = address & ~(s_page_size - 1);
+        uintptr_t faulted = range.faulted.load(std::memory_order_relaxed);
+        while (page < faulted && !range.faulted.compare_exchange_weak(faulted, page, std::memory_order_relaxed)) {
+        }
+        if (mmap(reinterpret_cast<void*>(page), s_page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) {
+            return;
+        }
+        break;
+    }
+
+    if (s_previous_bus_action.sa_flags & SA_SIGINFO) {
+        s_previous_bus_action.sa_sigaction(signal_number, info, context);
+    } else if (s_previous_bus_action.sa_handler != SIG_DFL && s_previous_bus_action.sa_handler != SIG_IGN) {
+        s_previous_bus_action.sa_handler(signal_number);
+    } else {
+        signal(SIGBUS, SIG_DFL);
+    }
+}
+
+static bool install_bus_guard() {
+    s_page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = on_bus_error;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    return sigaction(SIGBUS, &action, &s_previous_bus_action) == 0;
+}
+
+static uint32_t guard_range(const char* data, size_t size) {
+    static bool installed = install_bus_guard();
+    if (!installed) {
+        return MappedFile::MAX_GUARDED_MAPPINGS;
+    }
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    for (uint32_t i = 0; i < MappedFile::MAX_GUARDED_MAPPINGS; ++i) {
+        GuardedRange& range = s_guarded[i];
+        uintptr_t expected = 0;
+        if (range.begin.load(std::memory_order_relaxed) != 0
+            || !range.begin.compare_exchange_strong(expected, begin, std::memory_order_acq_rel)) {
+            continue;
+        }
+        range.faulted.store(UINTPTR_MAX, std::memory_order_relaxed);
+        range.end.store(begin + size, std::memory_order_release);
+        return i;
+    }
+    return MappedFile::MAX_GUARDED_MAPPINGS;
+}
+
+static void unguard_range(uint32_t guard) {
+    GuardedRange& range = s_guarded[guard];
+    range.end.store(0, std::memory_order_release);
+    range.begin.store(0, std::memory_order_release);
+}
+
+bool MappedFile::open(const char* path, bool) {
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    const char* data = nullptr;
+    uint32_t guard = MAX_GUARDED_MAPPINGS;
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        guard = guard_range(static_cast<const char*>(mapped), size);
+        if (guard == MAX_GUARDED_MAPPINGS) {
+            munmap(mapped, size);
+            ::close(fd);
+            return false;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+
+    _fd = fd;
+    _guard = guard;
+    _mtime = static_cast<int64_t>(st.st_mtime);
+    _device = static_cast<uint64_t>(st.st_dev);
+    _inode = static_cast<uint64_t>(st.st_ino);
+    _path_device = static_cast<uint64_t>(st.st_dev);
+    _path_inode = static_cast<uint64_t>(st.st_ino);
+    _data = data;
+    _size = size;
+    _open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (_guard != MAX_GUARDED_MAPPINGS) {
+        unguard_range(_guard);
+    }
+    if (_data) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+    _fd = -1;
+    _guard = MAX_GUARDED_MAPPINGS;
+    _mtime = 0;
+    _device = 0;
+    _inode = 0;
+    _path_device = 0;
+    _path_inode = 0;
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+bool MappedFile::is_same_file(const char* path) const {
+    struct stat st;
+    if (!_open || stat(path, &st) != 0) {
+        return false;
+    }
+    return static_cast<uint64_t>(st.st_dev) == _device && static_cast<uint64_t>(st.st_ino) == _inode;
+}
+
+FileChange MappedFile::check_changes(const char* path) const {
+    if (!_open) {
+        return FileChange::None;
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) == 0 && (static_cast<size_t>(st.st_size) != _size || static_cast<int64_t>(st.st_mtime) != _mtime)) {
+        return FileChange::Modified;
+    }
+
+    if (stat(path, &st) != 0) {
+        return FileChange::Removed;
+    }
+    if (static_cast<uint64_t>(st.st_dev) != _path_device || static_cast<uint64_t>(st.st_ino) != _path_inode) {
+        return FileChange::Replaced;
+    }
+    return FileChange::None;
+}
+
+size_t MappedFile::get_readable_size() const {
+    struct stat st;
+    if (!_open || fstat(_fd, &st) != 0) {
+        return 0;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (_guard != MAX_GUARDED_MAPPINGS) {
+        uintptr_t faulted = s_guarded[_guard].faulted.load(std::memory_order_relaxed);
+        if (faulted != UINTPTR_MAX && faulted - reinterpret_cast<uintptr_t>(_data) < size) {
+            size = faulted - reinterpret_cast<uintptr_t>(_data);
+        }
+    }
+    return size < _size ? size : _size;
+}
+
+void MappedFile::track_path(const char* path) {
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        _path_device = static_cast<uint64_t>(st.st_dev);
+        _path_inode = static_cast<uint64_t>(st.st_ino);
+    }
+}
+
+#endif
+
+}
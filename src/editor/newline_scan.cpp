@@ -0,0 +1,216 @@
+#include "lunaris/editor/newline_scan.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define LUNARIS_NEWLINE_SCAN_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define LUNARIS_TARGET_AVX2
+    #else
+        #define LUNARIS_TARGET_AVX2 __attribute__((target("avx2,popcnt,bmi")))
+    #endif
+#endif
+
+namespace lunaris {
+namespace text {
+
+using CountFunc = size_t(*)(const char*, size_t);
+using FindFunc = const char*(*)(const char*, size_t, size_t);
+
+size_t count_newlines_scalar(const char* data, size_t len) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static const char* find_nth_newline_scalar(const char* data, size_t len, size_t nth) {
+    const char* p = data;
+    const char* end = data + len;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) break;
+        if (nth == 0) return nl;
+        --nth;
+        p = nl + 1;
+    }
+    return nullptr;
+}
+
+#ifdef LUNARIS_NEWLINE_SCAN_X86
+
+static inline uint32_t popcount32(uint32_t v) {
+#ifdef _MSC_VER
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return (((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#else
+    return static_cast<uint32_t>(__builtin_popcount(v));
+#endif
+}
+
+static inline uint32_t lowest_bit_index(uint32_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctz(v));
+#endif
+}
+
+static inline uint32_t select_bit(uint32_t mask, size_t nth) {
+    while (nth > 0) {
+        mask &= mask - 1;
+        --nth;
+    }
+    return lowest_bit_index(mask);
+}
+
+static size_t count_newlines_sse2(const char* data, size_t len) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (len - i >= 16) {
+        size_t blocks = (len - i) / 16;
+        if (blocks > 255) blocks = 255;
+
+        __m128i acc = _mm_setzero_si128();
+        for (size_t b = 0; b < blocks; ++b, i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(chunk, newline));
+        }
+
+        __m128i sums = _mm_sad_epu8(acc, zero);
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+
+    return count + count_newlines_scalar(data + i, len - i);
+}
+
+static const char* find_nth_newline_sse2(const char* data, size_t len, size_t nth) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; len - i >= 16; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        if (!mask) continue;
+
+        uint32_t hits = popcount32(mask);
+        if (nth < hits) {
+            return data + i + select_bit(mask, nth);
+        }
+        nth -= hits;
+    }
+
+    return find_nth_newline_scalar(data + i, len - i, nth);
+}
+
+LUNARIS_TARGET_AVX2
+static size_t count_newlines_avx2(const char* data, size_t len) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t count = 0;
+    size_t i = 0;
+
+    while (len - i >= 32) {
+        size_t blocks = (len - i) / 32;
+        if (blocks > 255) blocks = 255;
+
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t b = 0; b < blocks; ++b, i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(chunk, newline));
+        }
+
+        __m256i sums = _mm256_sad_epu8(acc, zero);
+        count += static_cast<size_t>(_mm256_extract_epi64(sums, 0)) + static_cast<size_t>(_mm256_extract_epi64(sums, 1))
+            + static_cast<size_t>(_mm256_extract_epi64(sums, 2)) + static_cast<size_t>(_mm256_extract_epi64(sums, 3));
+    }
+
+    return count + count_newlines_sse2(data + i, len - i);
+}
+
+LUNARIS_TARGET_AVX2
+static const char* find_nth_newline_avx2(const char* data, size_t len, size_t nth) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+
+    for (; len - i >= 32; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        if (!mask) continue;
+
+        uint32_t hits = static_cast<uint32_t>(_mm_popcnt_u32(mask));
+        if (nth < hits) {
+            return data + i + select_bit(mask, nth);
+        }
+        nth -= hits;
+    }
+
+    return find_nth_newline_sse2(data + i, len - i, nth);
+}
+
+static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool popcnt = (info[2] & (1 << 23)) != 0;
+    if (!osxsave || !avx || !popcnt || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+}
+
+#endif
+
+struct NewlineScanDispatch {
+    CountFunc count;
+    FindFunc find;
+    const char* isa;
+};
+
+static NewlineScanDispatch select_dispatch() {
+#ifdef LUNARIS_NEWLINE_SCAN_X86
+    if (cpu_has_avx2()) {
+        return { count_newlines_avx2, find_nth_newline_avx2, "AVX2" };
+    }
+    return { count_newlines_sse2, find_nth_newline_sse2, "SSE2" };
+#else
+    return { count_newlines_scalar, find_nth_newline_scalar, "Scalar" };
+#endif
+}
+
+static const NewlineScanDispatch& get_dispatch() {
+    static const NewlineScanDispatch dispatch = select_dispatch();
+    return dispatch;
+}
+
+size_t count_newlines(const char* data, size_t len) {
+    return get_dispatch().count(data, len);
+}
+
+const char* find_nth_newline(const char* data, size_t len, size_t nth) {
+    return get_dispatch().find(data, len, nth);
+}
+
+const char* get_newline_scan_isa() {
+    return get_dispatch().isa;
+}
+
+}
+}
@@ -0,0 +1,164 @@
+#include "lunaris/editor/path_table.h"
+#include <cstring>
+
+namespace lunaris {
+
+PathTable::PathTable()
+    : _entries(nullptr)
+    , _entry_count(1)
+    , _entry_capacity(INITIAL_CAPACITY)
+    , _free_head(0)
+    , _live(0)
+    , _index(nullptr)
+    , _index_capacity(INITIAL_CAPACITY * 2)
+    , _index_used(0) {
+    _entries = new PathEntry[_entry_capacity];
+    _entries[0] = {};
+    _index = new PathID[_index_capacity];
+    memset(_index, 0, _index_capacity * sizeof(PathID));
+}
+
+PathTable::~PathTable() {
+    for (uint32_t i = 1; i < _entry_count; ++i) {
+        delete[] _entries[i].path;
+    }
+    delete[] _entries;
+    delete[] _index;
+}
+
+uint32_t PathTable::hash_path(const char* path, uint32_t length) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < length; ++i) {
+        hash ^= static_cast<uint8_t>(path[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t PathTable::find_slot(const char* path, uint32_t length, uint32_t hash) const {
+    uint32_t mask = _index_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (_index[slot] != INVALID_PATH_ID) {
+        const PathEntry& entry = _entries[_index[slot]];
+        if (entry.hash == hash && entry.length == length && memcmp(entry.path, path, length) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void PathTable::grow_entries() {
+    uint32_t capacity = _entry_capacity * 2;
+    PathEntry* entries = new PathEntry[capacity];
+    memcpy(entries, _entries, _entry_count * sizeof(PathEntry));
+    delete[] _entries;
+    _entries = entries;
+    _entry_capacity = capacity;
+}
+
+void PathTable::grow_index() {
+    uint32_t capacity = _index_capacity * 2;
+    PathID* index = new PathID[capacity];
+    memset(index, 0, capacity * sizeof(PathID));
+
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < _index_capacity; ++i) {
+        PathID id = _index[i];
+        if (id == INVALID_PATH_ID) continue;
+        uint32_t slot = _entries[id].hash & mask;
+        while (index[slot] != INVALID_PATH_ID) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = id;
+    }
+
+    delete[] _index;
+    _index = index;
+    _index_capacity = capacity;
+}
+
+PathID PathTable::intern(const char* path) {
+    uint32_t length = static_cast<uint32_t>(strlen(path));
+    uint32_t hash = hash_path(path, length);
+    uint32_t slot = find_slot(path, length, hash);
+    if (_index[slot] != INVALID_PATH_ID) {
+        ++_entries[_index[slot]].refs;
+        return _index[slot];
+    }
+
+    if ((_index_used + 1) * 2 > _index_capacity) {
+        grow_index();
+        slot = find_slot(path, length, hash);
+    }
+
+    PathID id = _free_head;
+    if (id != INVALID_PATH_ID) {
+        _free_head = _entries[id].next_free;
+    } else {
+        if (_entry_count == _entry_capacity) {
+            grow_entries();
+        }
+        id = _entry_count++;
+    }
+
+    PathEntry& entry = _entries[id];
+    entry.path = new char[length + 1];
+    memcpy(entry.path, path, length + 1);
+    entry.length = length;
+    entry.hash = hash;
+    entry.refs = 1;
+    entry.next_free = INVALID_PATH_ID;
+
+    _index[slot] = id;
+    ++_index_used;
+    ++_live;
+    return id;
+}
+
+PathID PathTable::find(const char* path) const {
+    uint32_t length = static_cast<uint32_t>(strlen(path));
+    return _index[find_slot(path, length, hash_path(path, length))];
+}
+
+void PathTable::retain(PathID id) {
+    if (id != INVALID_PATH_ID) {
+        ++_entries[id].refs;
+    }
+}
+
+void PathTable::release(PathID id) {
+    if (id == INVALID_PATH_ID) return;
+
+    PathEntry& entry = _entries[id];
+    if (--entry.refs > 0) return;
+
+    uint32_t mask = _index_capacity - 1;
+    uint32_t hole = entry.hash & mask;
+    while (_index[hole] != id) {
+        hole = (hole + 1) & mask;
+    }
+
+    uint32_t slot = hole;
+    while (true) {
+        slot = (slot + 1) & mask;
+        PathID moved = _index[slot];
+        if (moved == INVALID_PATH_ID) break;
+        uint32_t home = _entries[moved].hash & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            _index[hole] = moved;
+            hole = slot;
+        }
+    }
+    _index[hole] = INVALID_PATH_ID;
+    --_index_used;
+
+    delete[] entry.path;
+    entry.path = nullptr;
+    entry.length = 0;
+    entry.next_free = _free_head;
+    _free_head = id;
+    --_live;
+}
+
+}
@@ -0,0 +1,781 @@
+#include "lunaris/editor/piece_tree.h"
+#include "lunaris/editor/newline_scan.h"
+#include "lunaris/editor/mapped_file.h"
+#include "lunaris/editor/edit_batch.h"
+#include "lunaris/core/job_system.h"
+#include <cstring>
+#include <atomic>
+
+namespace lunaris {
+
+static size_t count_line_feeds(const TextChunk* chunk, size_t start, size_t end) {
+    const size_t* prefix = chunk->line_feed_prefix.load(std::memory_order_acquire);
+    size_t first_block = start / PieceTree::LINE_BLOCK_SIZE;
+    size_t last_block = end / PieceTree::LINE_BLOCK_SIZE;
+    if (!prefix || first_block == last_block) {
+        return text::count_newlines(chunk->data + start, end - start);
+    }
+
+    size_t head_end = (first_block + 1) * PieceTree::LINE_BLOCK_SIZE;
+    size_t tail_start = last_block * PieceTree::LINE_BLOCK_SIZE;
+    return text::count_newlines(chunk->data + start, head_end - start)
+        + prefix[last_block] - prefix[first_block + 1]
+        + text::count_newlines(chunk->data + tail_start, end - tail_start);
+}
+
+static size_t find_line_feed(const TextChunk* chunk, size_t start, size_t end, size_t nth) {
+    const size_t* prefix = chunk->line_feed_prefix.load(std::memory_order_acquire);
+    if (!prefix || end - start <= PieceTree::LINE_BLOCK_SIZE) {
+        return text::find_nth_newline(chunk->data + start, end - start, nth) - chunk->data;
+    }
+
+    size_t first_block = start / PieceTree::LINE_BLOCK_SIZE;
+    size_t block_start = first_block * PieceTree::LINE_BLOCK_SIZE;
+    size_t target = prefix[first_block] + text::count_newlines(chunk->data + block_start, start - block_start) + nth + 1;
+
+    size_t low = first_block;
+    size_t high = (chunk->length + PieceTree::LINE_BLOCK_SIZE - 1) / PieceTree::LINE_BLOCK_SIZE;
+    while (low < high) {
+        size_t mid = (low + high + 1) / 2;
+        if (prefix[mid] < target) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    size_t scan_start = low * PieceTree::LINE_BLOCK_SIZE;
+    size_t skip = target - prefix[low] - 1;
+    if (scan_start < start) {
+        scan_start = start;
+        skip = nth;
+    }
+    return text::find_nth_newline(chunk->data + scan_start, end - scan_start, skip) - chunk->data;
+}
+
+PieceTree::PieceTree()
+    : _root(nullptr)
+    , _add_chunk(nullptr)
+    , _chunks(nullptr)
+    , _chunk_count(0)
+    , _chunk_capacity(0)
+    , _seed(0x9E3779B9u)
+    , _pending_chunk(nullptr)
+    , _pending_prefix(nullptr)
+    , _indexed_blocks(0)
+    , _index_jobs(nullptr)
+    , _index_job(INVALID_JOB_ID) {
+}
+
+PieceTree::~PieceTree() {
+    clear();
+    delete[] _chunks;
+}
+
+uint32_t PieceTree::next_priority() {
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+}
+
+TextChunk* PieceTree::create_chunk(char* data, size_t length, size_t capacity, MappedFile* mapping) {
+    if (_chunk_count >= _chunk_capacity) {
+        uint32_t new_cap = _chunk_capacity == 0 ? 16 : _chunk_capacity * 2;
+        TextChunk** new_chunks = new TextChunk*[new_cap];
+        if (_chunks) {
+            memcpy(new_chunks, _chunks, _chunk_count * sizeof(TextChunk*));
+        }
+        delete[] _chunks;
+        _chunks = new_chunks;
+        _chunk_capacity = new_cap;
+    }
+
+    TextChunk* chunk = new TextChunk;
+    chunk->data = data;
+    chunk->length = length;
+    chunk->capacity = capacity;
+    chunk->line_feed_prefix.store(nullptr, std::memory_order_relaxed);
+    chunk->mapping = mapping;
+    chunk->refs.store(1, std::memory_order_relaxed);
+    _chunks[_chunk_count++] = chunk;
+    return chunk;
+}
+
+void PieceTree::retain_chunk(TextChunk* chunk) {
+    chunk->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PieceTree::release_chunk(TextChunk* chunk) {
+    if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (chunk->mapping) {
+        delete chunk->mapping;
+    } else {
+        delete[] chunk->data;
+    }
+    delete[] chunk->line_feed_prefix.load(std::memory_order_relaxed);
+    delete chunk;
+}
+
+void PieceTree::count_blocks(const TextChunk* chunk, size_t* prefix, size_t first_block, size_t last_block) {
+    for (size_t i = first_block; i < last_block; ++i) {
+        size_t begin = i * LINE_BLOCK_SIZE;
+        size_t len = chunk->length - begin < LINE_BLOCK_SIZE ? chunk->length - begin : LINE_BLOCK_SIZE;
+        prefix[i + 1] = text::count_newlines(chunk->data + begin, len);
+    }
+}
+
+void PieceTree::index_chunk(TextChunk* chunk, JobSystem* jobs) {
+    size_t block_count = (chunk->length + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    size_t* prefix = new size_t[block_count + 1];
+    prefix[0] = 0;
+
+    if (jobs && chunk->length >= PARALLEL_INDEX_THRESHOLD) {
+        jobs->parallel_for(0, block_count, PARALLEL_INDEX_GRAIN_BLOCKS, [chunk, prefix](size_t first, size_t last) {
+            count_blocks(chunk, prefix, first, last);
+        }, JobPriority::High);
+    } else {
+        count_blocks(chunk, prefix, 0, block_count);
+    }
+
+    for (size_t i = 0; i < block_count; ++i) {
+        prefix[i + 1] += prefix[i];
+    }
+    chunk->line_feed_prefix.store(prefix, std::memory_order_release);
+}
+
+void PieceTree::destroy_chunks() {
+    for (uint32_t i = 0; i < _chunk_count; ++i) {
+        release_chunk(_chunks[i]);
+    }
+    _chunk_count = 0;
+    _add_chunk = nullptr;
+}
+
+PieceNode* PieceTree::create_node(TextChunk* chunk, size_t start, size_t length, size_t line_feeds, uint32_t priority) {
+    PieceNode* node = new PieceNode;
+    node->left = nullptr;
+    node->right = nullptr;
+    node->chunk = chunk;
+    node->start = start;
+    node->length = length;
+    node->line_feeds = line_feeds;
+    node->subtree_length = length;
+    node->subtree_line_feeds = line_feeds;
+    node->priority = priority;
+    node->refs.store(1, std::memory_order_relaxed);
+    retain_chunk(chunk);
+    return node;
+}
+
+PieceNode* PieceTree::own(PieceNode* node) {
+    if (node->refs.load(std::memory_order_acquire) == 1) {
+        return node;
+    }
+
+    PieceNode* copy = new PieceNode;
+    copy->left = node->left;
+    copy->right = node->right;
+    copy->chunk = node->chunk;
+    copy->start = node->start;
+    copy->length = node->length;
+    copy->line_feeds = node->line_feeds;
+    copy->subtree_length = node->subtree_length;
+    copy->subtree_line_feeds = node->subtree_line_feeds;
+    copy->priority = node->priority;
+    copy->refs.store(1, std::memory_order_relaxed);
+    if (copy->left) copy->left->refs.fetch_add(1, std::memory_order_relaxed);
+    if (copy->right) copy->right->refs.fetch_add(1, std::memory_order_relaxed);
+    retain_chunk(copy->chunk);
+    release(node);
+    return copy;
+}
+
+void PieceTree::release(PieceNode* node) {
+    if (!node || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    release(node->left);
+    release(node->right);
+    release_chunk(node->chunk);
+    delete node;
+}
+
+PieceNode* PieceTree::share_root() const {
+    if (_root) {
+        _root->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return _root;
+}
+
+void PieceTree::replace_root(PieceNode* root) {
+    if (root) {
+        root->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    release(_root);
+    _root = root;
+}
+
+void PieceTree::update(PieceNode* node) {
+    node->subtree_length = subtree_length(node->left) + node->length + subtree_length(node->right);
+    node->subtree_line_feeds = subtree_line_feeds(node->left) + node->line_feeds + subtree_line_feeds(node->right);
+}
+
+void PieceTree::clear() {
+    cancel_indexing();
+    release(_root);
+    _root = nullptr;
+    destroy_chunks();
+}
+
+void PieceTree::adopt_chunk(TextChunk* chunk, JobSystem* jobs) {
+    index_chunk(chunk, jobs);
+    if (chunk->length > 0) {
+        _root = create_node(chunk, 0, chunk->length, count_line_feeds(chunk, 0, chunk->length), next_priority());
+    }
+}
+
+void PieceTree::adopt(char* data, size_t length, JobSystem* jobs) {
+    clear();
+    adopt_chunk(create_chunk(data, length, length, nullptr), jobs);
+}
+
+void PieceTree::adopt_mapping(MappedFile* mapping, JobSystem* jobs) {
+    clear();
+    size_t length = mapping->get_size();
+    adopt_chunk(create_chunk(const_cast<char*>(mapping->get_data()), length, length, mapping), jobs);
+}
+
+void PieceTree::adopt_deferred(MappedFile* mapping, JobSystem* jobs) {
+    clear();
+    size_t length = mapping->get_size();
+    TextChunk* chunk = create_chunk(const_cast<char*>(mapping->get_data()), length, length, mapping);
+    if (!jobs || length == 0) {
+        adopt_chunk(chunk, jobs);
+        return;
+    }
+
+    size_t block_count = (length + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    _pending_prefix = new size_t[block_count + 1];
+    _pending_prefix[0] = 0;
+    _root = create_node(chunk, 0, length, 0, next_priority());
+
+    _pending_chunk = chunk;
+    _indexed_blocks.store(0, std::memory_order_relaxed);
+    CancelToken token = _index_cancel.supersede();
+    _index_jobs = jobs;
+    _index_job = jobs->submit_lambda([this, token]() {
+        run_deferred_index(token);
+    }, "IndexLines", JobPriority::Low, token);
+
+    if (_index_job == INVALID_JOB_ID) {
+        run_deferred_index(token);
+        finish_indexing();
+    }
+}
+
+void PieceTree::run_deferred_index(const CancelToken& token) {
+    const TextChunk* chunk = _pending_chunk;
+    size_t block_count = (chunk->length + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    size_t line_feeds = 0;
+    size_t i = 0;
+
+    for (; i < block_count; ++i) {
+        if (i % INDEX_PUBLISH_BLOCKS == 0) {
+            _indexed_blocks.store(i, std::memory_order_release);
+            if (token.is_cancelled()) break;
+        }
+        size_t begin = i * LINE_BLOCK_SIZE;
+        size_t len = chunk->length - begin < LINE_BLOCK_SIZE ? chunk->length - begin : LINE_BLOCK_SIZE;
+        line_feeds += text::count_newlines(chunk->data + begin, len);
+        _pending_prefix[i + 1] = line_feeds;
+    }
+
+    _indexed_blocks.store(i, std::memory_order_release);
+}
+
+void PieceTree::cancel_indexing() {
+    if (!_pending_chunk) return;
+
+    _index_cancel.cancel();
+    _index_jobs->wait(_index_job);
+    delete[] _pending_prefix;
+    _pending_prefix = nullptr;
+    _pending_chunk = nullptr;
+}
+
+bool PieceTree::finish_indexing() {
+    if (!_pending_chunk || !_index_jobs->is_complete(_index_job)) {
+        return false;
+    }
+
+    size_t block_count = (_pending_chunk->length + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    if (_indexed_blocks.load(std::memory_order_acquire) != block_count) {
+        return false;
+    }
+    _pending_chunk->line_feed_prefix.store(_pending_prefix, std::memory_order_release);
+    _root = own(_root);
+    _root->line_feeds = _pending_prefix[block_count];
+    update(_root);
+    _pending_prefix = nullptr;
+    _pending_chunk = nullptr;
+    return true;
+}
+
+float PieceTree::get_index_progress() const {
+    if (!_pending_chunk) return 1.0f;
+    size_t block_count = (_pending_chunk->length + LINE_BLOCK_SIZE - 1) / LINE_BLOCK_SIZE;
+    return static_cast<float>(_indexed_blocks.load(std::memory_order_acquire)) / static_cast<float>(block_count);
+}
+
+void PieceTree::get_index_state(size_t& indexed_bytes, size_t& indexed_line_feeds, size_t& bytes_per_line) const {
+    size_t blocks = _indexed_blocks.load(std::memory_order_acquire);
+    indexed_bytes = blocks * LINE_BLOCK_SIZE;
+    if (indexed_bytes > _pending_chunk->length) indexed_bytes = _pending_chunk->length;
+    indexed_line_feeds = _pending_prefix[blocks];
+    bytes_per_line = (indexed_bytes + ESTIMATED_LINE_LENGTH) / (indexed_line_feeds + 1);
+}
+
+size_t PieceTree::estimate_line_start(size_t line) const {
+    const TextChunk* chunk = _pending_chunk;
+    size_t indexed_bytes, indexed_line_feeds, bytes_per_line;
+    get_index_state(indexed_bytes, indexed_line_feeds, bytes_per_line);
+
+    if (line <= indexed_line_feeds) {
+        size_t low = 0;
+        size_t high = _indexed_blocks.load(std::memory_order_acquire);
+        while (low < high) {
+            size_t mid = (low + high + 1) / 2;
+            if (_pending_prefix[mid] < line) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        size_t block_start = low * LINE_BLOCK_SIZE;
+        size_t block_len = chunk->length - block_start < LINE_BLOCK_SIZE ? chunk->length - block_start : LINE_BLOCK_SIZE;
+        const char* nl = text::find_nth_newline(chunk->data + block_start, block_len, line - _pending_prefix[low] - 1);
+        return (nl - chunk->data) + 1;
+    }
+
+    size_t pos = indexed_bytes + (line - indexed_line_feeds) * bytes_per_line;
+    if (pos >= chunk->length) return chunk->length;
+    size_t limit = pos > ESTIMATE_SNAP_LIMIT ? pos - ESTIMATE_SNAP_LIMIT : 0;
+    while (pos > limit && chunk->data[pos - 1] != '\n') {
+        --pos;
+    }
+    return pos;
+}
+
+size_t PieceTree::estimate_line_at(size_t pos) const {
+    const TextChunk* chunk = _pending_chunk;
+    size_t indexed_bytes, indexed_line_feeds, bytes_per_line;
+    get_index_state(indexed_bytes, indexed_line_feeds, bytes_per_line);
+
+    if (pos < indexed_bytes) {
+        size_t block = pos / LINE_BLOCK_SIZE;
+        size_t block_start = block * LINE_BLOCK_SIZE;
+        return _pending_prefix[block] + text::count_newlines(chunk->data + block_start, pos - block_start);
+    }
+    return indexed_line_feeds + (pos - indexed_bytes) / bytes_per_line;
+}
+
+size_t PieceTree::get_line_feed_count() const {
+    if (_pending_chunk) {
+        return estimate_line_at(_pending_chunk->length);
+    }
+    return view().get_line_feed_count();
+}
+
+size_t PieceTree::get_line_start(size_t line) const {
+    if (_pending_chunk) {
+        if (line == 0) return 0;
+        if (line > get_line_feed_count()) return get_length();
+        return estimate_line_start(line);
+    }
+    return view().get_line_start(line);
+}
+
+size_t PieceTree::get_line_end(size_t line) const {
+    if (_pending_chunk) {
+        return view().find_line_end(get_line_start(line));
+    }
+    return view().get_line_end(line);
+}
+
+size_t PieceTree::get_line_at(size_t pos) const {
+    if (_pending_chunk) {
+        if (pos >= get_length()) return get_line_feed_count();
+        return estimate_line_at(pos);
+    }
+    return view().get_line_at(pos);
+}
+
+bool PieceTree::detach_mapping(size_t readable_length) {
+    cancel_indexing();
+    bool truncated = false;
+    uint32_t count = _chunk_count;
+    for (uint32_t i = 0; i < count; ++i) {
+        TextChunk* chunk = _chunks[i];
+        if (!chunk->mapping) continue;
+
+        size_t keep = readable_length < chunk->length ? readable_length : chunk->length;
+        truncated = truncated || keep < chunk->length;
+        char* data = new char[keep > 0 ? keep : 1];
+        memcpy(data, chunk->data, keep);
+
+        TextChunk* copy = create_chunk(data, keep, keep, nullptr);
+        _chunks[i] = _chunks[--_chunk_count];
+        index_chunk(copy);
+        _root = rebind_chunk(_root, chunk, copy);
+        release_chunk(chunk);
+    }
+    return truncated;
+}
+
+MappedFile* PieceTree::get_mapping() const {
+    for (uint32_t i = 0; i < _chunk_count; ++i) {
+        if (_chunks[i]->mapping) return _chunks[i]->mapping;
+    }
+    return nullptr;
+}
+
+PieceNode* PieceTree::rebind_chunk(PieceNode* node, const TextChunk* from, TextChunk* to) {
+    if (!node) return nullptr;
+
+    node = own(node);
+    node->left = rebind_chunk(node->left, from, to);
+    node->right = rebind_chunk(node->right, from, to);
+    if (node->chunk == from && node->start >= to->length) {
+        PieceNode* merged = merge(node->left, node->right);
+        node->left = nullptr;
+        node->right = nullptr;
+        release(node);
+        return merged;
+    }
+    if (node->chunk == from) {
+        if (node->start + node->length > to->length) {
+            node->length = to->length - node->start;
+        }
+        retain_chunk(to);
+        release_chunk(node->chunk);
+        node->chunk = to;
+        node->line_feeds = count_line_feeds(to, node->start, node->start + node->length);
+    }
+    update(node);
+    return node;
+}
+
+void PieceTree::assign(const char* text, size_t length) {
+    char* data = new char[length > 0 ? length : 1];
+    if (length > 0) {
+        memcpy(data, text, length);
+    }
+    adopt(data, length);
+}
+
+void PieceTree::split(PieceNode* node, size_t pos, PieceNode*& left, PieceNode*& right) {
+    if (!node) {
+        left = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    node = own(node);
+    size_t left_len = subtree_length(node->left);
+    if (pos <= left_len) {
+        split(node->left, pos, left, node->left);
+        update(node);
+        right = node;
+    } else if (pos >= left_len + node->length) {
+        split(node->right, pos - left_len - node->length, node->right, right);
+        update(node);
+        left = node;
+    } else {
+        size_t offset = pos - left_len;
+        size_t head_line_feeds = count_line_feeds(node->chunk, node->start, node->start + offset);
+        PieceNode* tail = create_node(node->chunk, node->start + offset, node->length - offset,
+            node->line_feeds - head_line_feeds, node->priority);
+        tail->right = node->right;
+        node->right = nullptr;
+        node->length = offset;
+        node->line_feeds = head_line_feeds;
+        update(tail);
+        update(node);
+        left = node;
+        right = tail;
+    }
+}
+
+PieceNode* PieceTree::merge(PieceNode* left, PieceNode* right) {
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left->priority >= right->priority) {
+        left = own(left);
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+    right = own(right);
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+bool PieceTree::try_extend(size_t pos, const char* text, size_t len) {
+    if (pos == 0 || !_add_chunk || _add_chunk->capacity - _add_chunk->length < len) {
+        return false;
+    }
+
+    const PieceNode* node = _root;
+    size_t target = pos - 1;
+    while (node) {
+        size_t left_len = subtree_length(node->left);
+        if (target < left_len) {
+            node = node->left;
+        } else if (target < left_len + node->length) {
+            break;
+        } else {
+            target -= left_len + node->length;
+            node = node->right;
+        }
+    }
+
+    if (!node || node->chunk != _add_chunk) return false;
+    if (target - subtree_length(node->left) + 1 != node->length) return false;
+    if (node->start + node->length != _add_chunk->length) return false;
+    if (node->length + len > MAX_UNINDEXED_PIECE) return false;
+
+    memcpy(_add_chunk->data + _add_chunk->length, text, len);
+    _add_chunk->length += len;
+    size_t line_feeds = text::count_newlines(text, len);
+
+    PieceNode** link = &_root;
+    target = pos - 1;
+    while (*link) {
+        PieceNode* owned = own(*link);
+        *link = owned;
+        owned->subtree_length += len;
+        owned->subtree_line_feeds += line_feeds;
+        size_t left_len = subtree_length(owned->left);
+        if (target < left_len) {
+            link = &owned->left;
+        } else if (target < left_len + owned->length) {
+            owned->length += len;
+            owned->line_feeds += line_feeds;
+            return true;
+        } else {
+            target -= left_len + owned->length;
+            link = &owned->right;
+        }
+    }
+    return true;
+}
+
+PieceNode* PieceTree::append_text(const char* text, size_t len) {
+    if (len > MAX_UNINDEXED_PIECE) {
+        char* data = new char[len];
+        memcpy(data, text, len);
+        TextChunk* chunk = create_chunk(data, len, len, nullptr);
+        index_chunk(chunk);
+        return create_node(chunk, 0, len, count_line_feeds(chunk, 0, len), next_priority());
+    }
+
+    if (!_add_chunk || _add_chunk->capacity - _add_chunk->length < len) {
+        _add_chunk = create_chunk(new char[ADD_CHUNK_CAPACITY], 0, ADD_CHUNK_CAPACITY, nullptr);
+    }
+
+    size_t start = _add_chunk->length;
+    memcpy(_add_chunk->data + start, text, len);
+    _add_chunk->length += len;
+    return create_node(_add_chunk, start, len, text::count_newlines(text, len), next_priority());
+}
+
+void PieceTree::insert(size_t pos, const char* text, size_t len) {
+    if (len == 0 || pos > get_length()) return;
+
+    if (try_extend(pos, text, len)) return;
+
+    PieceNode* piece = append_text(text, len);
+    PieceNode* left = nullptr;
+    PieceNode* right = nullptr;
+    split(_root, pos, left, right);
+    _root = merge(merge(left, piece), right);
+}
+
+void PieceTree::remove(size_t pos, size_t len) {
+    size_t total = get_length();
+    if (len == 0 || pos >= total) return;
+    if (pos + len > total) len = total - pos;
+
+    PieceNode* left = nullptr;
+    PieceNode* rest = nullptr;
+    PieceNode* middle = nullptr;
+    PieceNode* right = nullptr;
+    split(_root, pos, left, rest);
+    split(rest, len, middle, right);
+    release(middle);
+    _root = merge(left, right);
+}
+
+void PieceTree::apply(const EditBatch& batch, bool revert) {
+    PieceNode* result = nullptr;
+    PieceNode* rest = _root;
+    PieceNode* head = nullptr;
+    PieceNode* middle = nullptr;
+    size_t consumed = 0;
+    size_t added = 0;
+    size_t dropped = 0;
+
+    for (uint32_t i = 0; i < batch.get_count(); ++i) {
+        const BatchEdit& edit = batch.get_edit(i);
+        size_t pos = revert ? edit.pos + added - dropped : edit.pos;
+        size_t remove_len = revert ? edit.inserted : edit.removed;
+        size_t insert_len = revert ? edit.removed : edit.inserted;
+        const char* text = revert ? batch.get_removed_text(i) : batch.get_inserted_text(i);
+
+        split(rest, pos - consumed, head, rest);
+        result = merge(result, head);
+        split(rest, remove_len, middle, rest);
+        release(middle);
+        if (insert_len > 0) {
+            result = merge(result, append_text(text, insert_len));
+        }
+
+        consumed = pos + remove_len;
+        added += edit.inserted;
+        dropped += edit.removed;
+    }
+
+    _root = merge(result, rest);
+}
+
+bool PieceView::span_at(size_t pos, TextSpan& out) const {
+    const PieceNode* node = _root;
+    while (node) {
+        size_t left_len = node->left ? node->left->subtree_length : 0;
+        if (pos < left_len) {
+            node = node->left;
+        } else if (pos < left_len + node->length) {
+            size_t offset = pos - left_len;
+            out.data = node->chunk->data + node->start + offset;
+            out.length = node->length - offset;
+            return true;
+        } else {
+            pos -= left_len + node->length;
+            node = node->right;
+        }
+    }
+    out.data = nullptr;
+    out.length = 0;
+    return false;
+}
+
+size_t PieceView::get_line_start(size_t line) const {
+    if (line == 0) return 0;
+    if (line > get_line_feed_count()) return get_length();
+
+    const PieceNode* node = _root;
+    size_t base = 0;
+    while (node) {
+        size_t left_len = node->left ? node->left->subtree_length : 0;
+        size_t left_line_feeds = node->left ? node->left->subtree_line_feeds : 0;
+        if (line <= left_line_feeds) {
+            node = node->left;
+        } else if (line <= left_line_feeds + node->line_feeds) {
+            size_t nl = find_line_feed(node->chunk, node->start, node->start + node->length, line - left_line_feeds - 1);
+            return base + left_len + (nl - node->start) + 1;
+        } else {
+            line -= left_line_feeds + node->line_feeds;
+            base += left_len + node->length;
+            node = node->right;
+        }
+    }
+    return get_length();
+}
+
+size_t PieceView::get_line_end(size_t line) const {
+    if (line < get_line_feed_count()) {
+        return get_line_start(line + 1) - 1;
+    }
+    return get_length();
+}
+
+size_t PieceView::find_line_end(size_t pos) const {
+    size_t length = get_length();
+    TextIterator it(_root, pos, length);
+    TextSpan span;
+    while (it.next(span)) {
+        const char* nl = text::find_nth_newline(span.data, span.length, 0);
+        if (nl) {
+            return pos + (nl - span.data);
+        }
+        pos += span.length;
+    }
+    return length;
+}
+
+size_t PieceView::get_line_at(size_t pos) const {
+    if (pos >= get_length()) return get_line_feed_count();
+
+    const PieceNode* node = _root;
+    size_t line = 0;
+    while (node) {
+        size_t left_len = node->left ? node->left->subtree_length : 0;
+        size_t left_line_feeds = node->left ? node->left->subtree_line_feeds : 0;
+        if (pos < left_len) {
+            node = node->left;
+        } else if (pos < left_len + node->length) {
+            size_t offset = pos - left_len;
+            return line + left_line_feeds + count_line_feeds(node->chunk, node->start, node->start + offset);
+        } else {
+            pos -= left_len + node->length;
+            line += left_line_feeds + node->line_feeds;
+            node = node->right;
+        }
+    }
+    return line;
+}
+
+char PieceView::char_at(size_t pos) const {
+    TextSpan span;
+    if (!span_at(pos, span)) {
+        return '\0';
+    }
+    return span.data[0];
+}
+
+size_t PieceView::copy_range(size_t pos, size_t len, char* out) const {
+    size_t copied = 0;
+    TextIterator it(_root, pos, pos + len);
+    TextSpan span;
+    while (it.next(span)) {
+        memcpy(out + copied, span.data, span.length);
+        copied += span.length;
+    }
+    return copied;
+}
+
+TextIterator::TextIterator(const PieceNode* root, size_t start, size_t end)
+    : _root(root)
+    , _pos(start)
+    , _end(end) {
+    size_t length = root ? root->subtree_length : 0;
+    if (_end > length) _end = length;
+}
+
+bool TextIterator::next(TextSpan& span) {
+    if (_pos >= _end || !PieceView(_root).span_at(_pos, span)) {
+        return false;
+    }
+    if (span.length > _end - _pos) {
+        span.length = _end - _pos;
+    }
+    _pos += span.length;
+    return true;
+}
+
+}
@@ -1,235 +1,224 @@
 #include "lunaris/editor/text_buffer.h"
+#include "lunaris/core/async_file.h"
 #include <cstring>
 #include <cstdio>
 
+#ifndef _WIN32
+    #include <sys/stat.h>
+    #include <climits>
+    #include <cstdlib>
+#endif
+
 namespace lunaris {
 
 TextBuffer::TextBuffer()
-    : _data(nullptr)
-    , _length(0)
-    , _capacity(0)
-    , _line_count(1)
-    , _line_starts(nullptr)
-    , _line_starts_capacity(0)
-    , _modified(false)
+    : _modified(false)
     , _version(0)
-    , _undo_stack(nullptr)
-    , _undo_count(0)
-    , _redo_stack(nullptr)
-    , _redo_count(0) {
-    ensure_capacity(INITIAL_CAPACITY);
-    _line_starts_capacity = 1024;
-    _line_starts = new size_t[_line_starts_capacity];
-    _line_starts[0] = 0;
-    _undo_stack = new EditOperation[MAX_UNDO_HISTORY];
-    _redo_stack = new EditOperation[MAX_UNDO_HISTORY];
+    , _batch_open(false) {
 }
 
 TextBuffer::~TextBuffer() {
-    clear_history();
-    delete[] _undo_stack;
-    delete[] _redo_stack;
-    delete[] _data;
-    delete[] _line_starts;
 }
 
-void TextBuffer::ensure_capacity(size_t required) {
-    if (required <= _capacity) {
-        return;
+bool TextBuffer::load_from_file(const char* path, JobSystem* jobs) {
+    size_t old_length = _tree.get_length();
+    MappedFile* mapping = new MappedFile();
+    if (mapping->open(path)) {
+        size_t size = mapping->get_size();
+        if (size >= LARGE_FILE_THRESHOLD && jobs) {
+            _tree.adopt_deferred(mapping, jobs);
+        } else if (size >= MMAP_THRESHOLD) {
+            _tree.adopt_mapping(mapping, jobs);
+        } else {
+            char* data = new char[size > 0 ? size : 1];
+            memcpy(data, mapping->get_data(), size);
+            delete mapping;
+            _tree.adopt(data, size, jobs);
+        }
+    } else {
+        delete mapping;
+        size_t size = 0;
+        char* data = read_whole_file(path, size);
+        if (!data) {
+            return false;
+        }
+        _tree.adopt(data, size, jobs);
+    }
+
+    _modified = false;
+    ++_version;
+    _journal.record(0, old_length, _tree.get_length(), _version);
+    return true;
+}
+
+bool TextBuffer::write_to(FILE* f) const {
+    size_t length = _tree.get_length();
+    size_t written = 0;
+    TextIterator it = get_range(0, length);
+    TextSpan span;
+    while (it.next(span)) {
+        written += fwrite(span.data, 1, span.length, f);
     }
+    return written == length;
+}
 
-    size_t new_capacity = _capacity == 0 ? INITIAL_CAPACITY : _capacity;
-    while (new_capacity < required) {
-        new_capacity *= 2;
+bool TextBuffer::save_to_file(const char* path) {
+    MappedFile* mapping = _tree.get_mapping();
+    if (mapping && mapping->is_same_file(path)) {
+#ifdef _WIN32
+        detach_backing_file();
+#else
+        return save_replacing(path);
+#endif
     }
 
-    char* new_data = new char[new_capacity];
-    if (_data && _length > 0) {
-        memcpy(new_data, _data, _length);
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
     }
-    delete[] _data;
-    _data = new_data;
-    _capacity = new_capacity;
-}
-
-void TextBuffer::rebuild_line_starts() {
-    _line_count = 1;
-    _line_starts[0] = 0;
-
-    for (size_t i = 0; i < _length; ++i) {
-        if (_data[i] == '\n') {
-            if (_line_count >= _line_starts_capacity) {
-                size_t new_cap = _line_starts_capacity * 2;
-                size_t* new_starts = new size_t[new_cap];
-                memcpy(new_starts, _line_starts, _line_count * sizeof(size_t));
-                delete[] _line_starts;
-                _line_starts = new_starts;
-                _line_starts_capacity = new_cap;
-            }
-            _line_starts[_line_count] = i + 1;
-            ++_line_count;
-        }
+
+    bool ok = write_to(f);
+    ok = fclose(f) == 0 && ok;
+    if (ok) {
+        _modified = false;
     }
+    return ok;
 }
 
-bool TextBuffer::load_from_file(const char* path) {
-    FILE* f = fopen(path, "rb");
-    if (!f) {
+#ifndef _WIN32
+bool TextBuffer::save_replacing(const char* path) {
+    char resolved[PATH_MAX];
+    if (!realpath(path, resolved)) {
         return false;
     }
 
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    char temp[PATH_MAX + 16];
+    snprintf(temp, sizeof(temp), "%s.lunaris-save", resolved);
 
-    if (size < 0) {
-        fclose(f);
+    FILE* f = fopen(temp, "wb");
+    if (!f) {
         return false;
     }
 
-    ensure_capacity(static_cast<size_t>(size) + 1);
-    size_t read = fread(_data, 1, static_cast<size_t>(size), f);
-    fclose(f);
+    bool ok = write_to(f);
+    ok = fclose(f) == 0 && ok;
 
-    _length = read;
-    _data[_length] = '\0';
-    rebuild_line_starts();
+    struct stat st;
+    if (ok && stat(resolved, &st) == 0) {
+        chmod(temp, st.st_mode & 07777);
+    }
+
+    if (!ok || rename(temp, resolved) != 0) {
+        ::remove(temp);
+        return false;
+    }
+
+    _tree.get_mapping()->track_path(path);
     _modified = false;
-    ++_version;
     return true;
 }
+#endif
 
-bool TextBuffer::save_to_file(const char* path) {
-    FILE* f = fopen(path, "wb");
-    if (!f) {
+FileChange TextBuffer::check_backing_file(const char* path) const {
+    MappedFile* mapping = _tree.get_mapping();
+    return mapping ? mapping->check_changes(path) : FileChange::None;
+}
+
+bool TextBuffer::detach_backing_file() {
+    MappedFile* mapping = _tree.get_mapping();
+    if (!mapping) {
         return false;
     }
+    size_t length = _tree.get_length();
+    _history.drop_checkpoints();
+    bool truncated = _tree.detach_mapping(mapping->get_readable_size());
+    if (truncated) {
+        _history.clear();
+        _modified = true;
+    }
+    ++_version;
+    _journal.record(0, length, _tree.get_length(), _version);
+    return truncated;
+}
 
-    size_t written = fwrite(_data, 1, _length, f);
-    fclose(f);
-
-    if (written == _length) {
-        _modified = false;
-        return true;
+bool TextBuffer::finish_indexing() {
+    if (!_tree.finish_indexing()) {
+        return false;
     }
-    return false;
+    ++_version;
+    return true;
+}
+
+TextSnapshot* TextBuffer::snapshot() const {
+    return new TextSnapshot(_tree.share_root(), _version, !_tree.is_indexing());
 }
 
 void TextBuffer::set_text(const char* text, size_t length) {
-    ensure_capacity(length + 1);
-    memcpy(_data, text, length);
-    _data[length] = '\0';
-    _length = length;
-    rebuild_line_starts();
+    size_t old_length = _tree.get_length();
+    _tree.assign(text, length);
     _modified = true;
     ++_version;
+    _journal.record(0, old_length, length, _version);
 }
 
 void TextBuffer::clear() {
-    _length = 0;
-    if (_data) {
-        _data[0] = '\0';
-    }
-    _line_count = 1;
-    _line_starts[0] = 0;
+    size_t old_length = _tree.get_length();
+    _tree.clear();
     _modified = false;
     ++_version;
+    _journal.record(0, old_length, 0, _version);
     clear_history();
 }
 
 void TextBuffer::insert(size_t pos, const char* text, size_t len, size_t cursor_pos) {
-    if (pos > _length || len == 0) {
+    if (pos > _tree.get_length() || len == 0 || _tree.is_indexing()) {
         return;
     }
 
-    EditOperation op;
-    op.type = EditType::Insert;
-    op.pos = pos;
-    op.text = new char[len + 1];
-    memcpy(op.text, text, len);
-    op.text[len] = '\0';
-    op.len = len;
-    op.cursor_before = cursor_pos;
-    op.cursor_after = pos + len;
-    push_undo(op);
-    clear_redo();
-
+    PieceNode* root_before = len >= UndoHistory::CHECKPOINT_LENGTH ? _tree.share_root() : nullptr;
+    _history.record_insert(pos, text, len, cursor_pos);
     insert_raw(pos, text, len);
+    if (len >= UndoHistory::CHECKPOINT_LENGTH) {
+        _history.attach_checkpoint(root_before, _tree.share_root());
+    }
 }
 
 void TextBuffer::remove(size_t pos, size_t len, size_t cursor_pos) {
-    if (pos >= _length || len == 0) {
+    size_t length = _tree.get_length();
+    if (pos >= length || len == 0 || _tree.is_indexing()) {
         return;
     }
 
-    if (pos + len > _length) {
-        len = _length - pos;
+    if (pos + len > length) {
+        len = length - pos;
     }
 
-    EditOperation op;
-    op.type = EditType::Remove;
-    op.pos = pos;
-    op.text = new char[len + 1];
-    memcpy(op.text, _data + pos, len);
-    op.text[len] = '\0';
-    op.len = len;
-    op.cursor_before = cursor_pos;
-    op.cursor_after = pos;
-    push_undo(op);
-    clear_redo();
-
+    PieceNode* root_before = len >= UndoHistory::CHECKPOINT_LENGTH ? _tree.share_root() : nullptr;
+    _tree.view().copy_range(pos, len, _history.record_remove(pos, len, cursor_pos));
     remove_raw(pos, len);
+    if (len >= UndoHistory::CHECKPOINT_LENGTH) {
+        _history.attach_checkpoint(root_before, _tree.share_root());
+    }
 }
 
 char TextBuffer::char_at(size_t pos) const {
-    if (pos >= _length) {
-        return '\0';
-    }
-    return _data[pos];
+    return _tree.view().char_at(pos);
 }
 
 size_t TextBuffer::get_line_start(uint32_t line) const {
-    if (line >= _line_count) {
-        return _length;
-    }
-    return _line_starts[line];
+    return _tree.get_line_start(line);
 }
 
 size_t TextBuffer::get_line_end(uint32_t line) const {
-    if (line >= _line_count) {
-        return _length;
-    }
-    if (line + 1 < _line_count) {
-        size_t end = _line_starts[line + 1];
-        if (end > 0 && _data[end - 1] == '\n') {
-            return end - 1;
-        }
-        return end;
-    }
-    return _length;
+    return _tree.get_line_end(line);
 }
 
 uint32_t TextBuffer::get_line_at_pos(size_t pos) const {
-    if (pos >= _length) {
-        return _line_count > 0 ? _line_count - 1 : 0;
-    }
-
-    uint32_t low = 0;
-    uint32_t high = _line_count;
-    while (low < high) {
-        uint32_t mid = (low + high) / 2;
-        if (_line_starts[mid] <= pos) {
-            low = mid + 1;
-        } else {
-            high = mid;
-        }
-    }
-    return low > 0 ? low - 1 : 0;
+    return static_cast<uint32_t>(_tree.get_line_at(pos));
 }
 
 size_t TextBuffer::get_column_at_pos(size_t pos) const {
-    uint32_t line = get_line_at_pos(pos);
-    return pos - _line_starts[line];
+    return pos - _tree.get_line_start(_tree.get_line_at(pos));
 }
 
 size_t TextBuffer::pos_from_line_col(uint32_t line, size_t col) const {
@@ -242,138 +231,126 @@ size_t TextBuffer::pos_from_line_col(uint32_t line, size_t col) const {
     return line_start + col;
 }
 
-void TextBuffer::insert_no_history(size_t pos, const char* text, size_t len) {
-    if (pos > _length || len == 0) return;
-    insert_raw(pos, text, len);
+void TextBuffer::begin_batch() {
+    _batch.clear();
+    _batch_open = true;
 }
 
-void TextBuffer::remove_no_history(size_t pos, size_t len) {
-    if (pos >= _length || len == 0) return;
-    if (pos + len > _length) len = _length - pos;
-    remove_raw(pos, len);
+void TextBuffer::batch_replace(size_t pos, size_t removed, const char* text, size_t len) {
+    if (!_batch_open) return;
+    _batch.add(pos, removed, text, len);
+}
+
+bool TextBuffer::commit(size_t cursor_before, size_t cursor_after) {
+    if (!_batch_open) return false;
+    _batch_open = false;
+
+    if (_batch.get_count() == 0 || _tree.is_indexing() || !_batch.prepare(_tree.view())) {
+        _batch.clear();
+        return false;
+    }
+
+    EditBatch* batch = _batch.clone();
+    bool checkpoint = batch->get_count() >= UndoHistory::CHECKPOINT_EDITS || batch->get_text_size() >= UndoHistory::CHECKPOINT_LENGTH;
+    PieceNode* root_before = checkpoint ? _tree.share_root() : nullptr;
+    _history.record_batch(batch, cursor_before, cursor_after);
+    apply_batch_raw(*batch, false);
+    if (checkpoint) {
+        _history.attach_checkpoint(root_before, _tree.share_root());
+    }
+    _batch.clear();
+    return true;
 }
 
 void TextBuffer::insert_raw(size_t pos, const char* text, size_t len) {
-    ensure_capacity(_length + len + 1);
-    memmove(_data + pos + len, _data + pos, _length - pos);
-    memcpy(_data + pos, text, len);
-    _length += len;
-    _data[_length] = '\0';
-    rebuild_line_starts();
+    _tree.insert(pos, text, len);
     _modified = true;
     ++_version;
+    _journal.record(pos, 0, len, _version);
 }
 
 void TextBuffer::remove_raw(size_t pos, size_t len) {
-    memmove(_data + pos, _data + pos + len, _length - pos - len);
-    _length -= len;
-    _data[_length] = '\0';
-    rebuild_line_starts();
+    _tree.remove(pos, len);
     _modified = true;
     ++_version;
+    _journal.record(pos, len, 0, _version);
 }
 
-void TextBuffer::push_undo(EditOperation op) {
-    if (_undo_count >= MAX_UNDO_HISTORY) {
-        free_operation(_undo_stack[0]);
-        for (size_t i = 0; i < MAX_UNDO_HISTORY - 1; ++i) {
-            _undo_stack[i] = _undo_stack[i + 1];
-        }
-        --_undo_count;
-    }
-    _undo_stack[_undo_count] = op;
-    ++_undo_count;
+void TextBuffer::apply_batch_raw(const EditBatch& batch, bool revert) {
+    _tree.apply(batch, revert);
+    _modified = true;
+    ++_version;
+    journal_batch(batch, revert);
 }
 
-void TextBuffer::push_redo(EditOperation op) {
-    if (_redo_count >= MAX_UNDO_HISTORY) {
-        free_operation(_redo_stack[0]);
-        for (size_t i = 0; i < MAX_UNDO_HISTORY - 1; ++i) {
-            _redo_stack[i] = _redo_stack[i + 1];
+void TextBuffer::journal_batch(const EditBatch& batch, bool revert) {
+    size_t added = 0;
+    size_t dropped = 0;
+    for (uint32_t i = 0; i < batch.get_count(); ++i) {
+        const BatchEdit& edit = batch.get_edit(i);
+        if (revert) {
+            _journal.record(edit.pos, edit.inserted, edit.removed, _version);
+        } else {
+            _journal.record(edit.pos + added - dropped, edit.removed, edit.inserted, _version);
         }
-        --_redo_count;
+        added += edit.inserted;
+        dropped += edit.removed;
     }
-    _redo_stack[_redo_count] = op;
-    ++_redo_count;
 }
 
-void TextBuffer::free_operation(EditOperation& op) {
-    delete[] op.text;
-    op.text = nullptr;
-}
+void TextBuffer::apply_entry(const UndoEntry& entry, bool revert) {
+    bool insert = (entry.type == EditType::Insert) != revert;
+    if (!entry.checkpoint) {
+        if (entry.type == EditType::Batch) {
+            apply_batch_raw(*entry.batch, revert);
+        } else if (insert) {
+            insert_raw(entry.pos, entry.text, entry.len);
+        } else {
+            remove_raw(entry.pos, entry.len);
+        }
+        return;
+    }
 
-void TextBuffer::clear_redo() {
-    for (size_t i = 0; i < _redo_count; ++i) {
-        free_operation(_redo_stack[i]);
+    _tree.replace_root(revert ? entry.root_before : entry.root_after);
+    _modified = true;
+    ++_version;
+    if (entry.type == EditType::Batch) {
+        journal_batch(*entry.batch, revert);
+    } else {
+        _journal.record(entry.pos, insert ? 0 : entry.len, insert ? entry.len : 0, _version);
     }
-    _redo_count = 0;
 }
 
 void TextBuffer::clear_history() {
-    for (size_t i = 0; i < _undo_count; ++i) {
-        free_operation(_undo_stack[i]);
-    }
-    _undo_count = 0;
-    clear_redo();
+    _history.clear();
 }
 
 size_t TextBuffer::undo() {
-    if (_undo_count == 0) {
+    if (_tree.is_indexing()) {
         return 0;
     }
 
-    --_undo_count;
-    EditOperation& op = _undo_stack[_undo_count];
-
-    EditOperation redo_op;
-    redo_op.type = op.type;
-    redo_op.pos = op.pos;
-    redo_op.len = op.len;
-    redo_op.text = new char[op.len + 1];
-    memcpy(redo_op.text, op.text, op.len + 1);
-    redo_op.cursor_before = op.cursor_before;
-    redo_op.cursor_after = op.cursor_after;
-
-    if (op.type == EditType::Insert) {
-        remove_raw(op.pos, op.len);
-    } else {
-        insert_raw(op.pos, op.text, op.len);
+    const UndoEntry* entry = _history.undo();
+    if (!entry) {
+        return 0;
     }
 
-    push_redo(redo_op);
-    free_operation(_undo_stack[_undo_count]);
-
-    return op.cursor_before;
+    apply_entry(*entry, true);
+    return entry->cursor_before;
 }
 
 size_t TextBuffer::redo() {
-    if (_redo_count == 0) {
+    if (_tree.is_indexing()) {
         return 0;
     }
 
-    --_redo_count;
-    EditOperation& op = _redo_stack[_redo_count];
-
-    EditOperation undo_op;
-    undo_op.type = op.type;
-    undo_op.pos = op.pos;
-    undo_op.len = op.len;
-    undo_op.text = new char[op.len + 1];
-    memcpy(undo_op.text, op.text, op.len + 1);
-    undo_op.cursor_before = op.cursor_before;
-    undo_op.cursor_after = op.cursor_after;
-
-    if (op.type == EditType::Insert) {
-        insert_raw(op.pos, op.text, op.len);
-    } else {
-        remove_raw(op.pos, op.len);
+    const UndoEntry* entry = _history.redo();
+    if (!entry) {
+        return 0;
     }
 
-    _undo_stack[_undo_count] = undo_op;
-    ++_undo_count;
-    free_operation(_redo_stack[_redo_count]);
-
-    return op.cursor_after;
+    apply_entry(*entry, false);
+    return entry->cursor_after;
 }
 
 }
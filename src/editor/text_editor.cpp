@@ -28,10 +28,44 @@ TextEditor::TextEditor()
     , _focus_requested(false)
     , _blink_timer(0.0f)
     , _cursor_visible(true)
-    , _dragging(false) {
+    , _dragging(false)
+    , _read_only_notice(0.0f)
+    , _scratch(nullptr)
+    , _scratch_capacity(0) {
 }
 
 TextEditor::~TextEditor() {
+    delete[] _scratch;
+}
+
+const char* TextEditor::fetch_range(size_t start, size_t end) const {
+    TextBuffer* buffer = _document->get_buffer();
+    TextIterator it = buffer->get_range(start, end);
+    TextSpan span;
+    if (!it.next(span)) {
+        return "";
+    }
+    if (span.length == end - start) {
+        return span.data;
+    }
+
+    size_t len = end - start;
+    if (len > _scratch_capacity) {
+        size_t new_cap = _scratch_capacity == 0 ? 256 : _scratch_capacity;
+        while (new_cap < len) {
+            new_cap *= 2;
+        }
+        delete[] _scratch;
+        _scratch = new char[new_cap];
+        _scratch_capacity = new_cap;
+    }
+
+    size_t copied = 0;
+    do {
+        memcpy(_scratch + copied, span.data, span.length);
+        copied += span.length;
+    } while (it.next(span));
+    return _scratch;
 }
 
 void TextEditor::set_document(Document* doc) {
@@ -131,6 +165,31 @@ void TextEditor::on_ui() {
     if (_focused && _cursor_visible) {
         draw_cursor(text_x, text_y);
     }
+
+    if (_read_only_notice > 0.0f) {
+        _read_only_notice -= io.DeltaTime;
+    }
+    if (buffer->is_indexing()) {
+        draw_read_only_badge(content_pos.x + content_size.x, content_pos.y);
+    }
+}
+
+void TextEditor::draw_read_only_badge(float right, float top) {
+    const char* label = "Read-only while indexing lines";
+    ImVec2 size = ImGui::CalcTextSize(label);
+    float padding = 6.0f;
+    ImVec2 min(right - size.x - padding * 3.0f, top + padding);
+    ImVec2 max(right - padding, top + size.y + padding * 3.0f);
+
+    Color surface = _theme ? _theme->get_surface() : Color(0.16f, 0.16f, 0.19f);
+    Color text = _theme ? _theme->get_text_dim() : Color(0.5f, 0.5f, 0.55f);
+    if (_read_only_notice > 0.0f) {
+        text = _theme ? _theme->get_warning() : Color(0.9f, 0.7f, 0.3f);
+    }
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    draw_list->AddRectFilled(min, max, ImColor(surface.r, surface.g, surface.b, 0.9f), 4.0f);
+    draw_list->AddText(ImVec2(min.x + padding, min.y + padding), ImColor(text.r, text.g, text.b, 1.0f), label);
 }
 
 void TextEditor::draw_gutter(float content_x, float content_y, float gutter_w, float height) {
@@ -188,23 +247,25 @@ void TextEditor::draw_text(float x, float y, float width, float height) {
     uint32_t first_line = static_cast<uint32_t>(_scroll_y / line_h);
     uint32_t visible_lines = static_cast<uint32_t>(height / line_h) + 2;
     
-    const char* text = buffer->get_text();
     ImVec2 clip_min(x - LEFT_MARGIN, y - TOP_MARGIN);
     ImVec2 clip_max(x + width, y - TOP_MARGIN + height);
     draw_list->PushClipRect(clip_min, clip_max, true);
     
-    for (uint32_t i = 0; i < visible_lines && first_line + i < total_lines; ++i) {
+    size_t length = buffer->get_length();
+    size_t line_start = buffer->get_line_start(first_line);
+    for (uint32_t i = 0; i < visible_lines && first_line + i < total_lines && line_start <= length; ++i) {
         uint32_t line_idx = first_line + i;
-        size_t line_start = buffer->get_line_start(line_idx);
-        size_t line_end = buffer->get_line_end(line_idx);
+        size_t line_end = buffer->get_line_end_at(line_start);
         
         float ly = y + line_idx * line_h - _scroll_y + text_offset_y;
         
         if (line_start < line_end) {
+            const char* text = fetch_range(line_start, line_end);
             draw_list->AddText(ImVec2(x - _scroll_x, ly),
                 ImColor(text_col.r, text_col.g, text_col.b, 1.0f),
-                text + line_start, text + line_end);
+                text, text + (line_end - line_start));
         }
+        line_start = line_end + 1;
     }
     
     draw_list->PopClipRect();
@@ -225,7 +286,6 @@ void TextEditor::draw_selection(float x, float y, float width) {
     uint32_t end_line = buffer->get_line_at_pos(sel_end);
     
     float line_h = get_line_height();
-    const char* text = buffer->get_text();
     
     for (uint32_t line = start_line; line <= end_line; ++line) {
         size_t line_start = buffer->get_line_start(line);
@@ -233,15 +293,16 @@ void TextEditor::draw_selection(float x, float y, float width) {
         
         size_t sel_line_start = (line == start_line) ? sel_start : line_start;
         size_t sel_line_end = (line == end_line) ? sel_end : line_end;
+        const char* text = fetch_range(line_start, sel_line_end);
         
         float start_x = x - _scroll_x;
         if (sel_line_start > line_start) {
-            start_x += ImGui::CalcTextSize(text + line_start, text + sel_line_start).x;
+            start_x += ImGui::CalcTextSize(text, text + (sel_line_start - line_start)).x;
         }
         
         float end_x = x - _scroll_x;
         if (sel_line_end > line_start) {
-            end_x += ImGui::CalcTextSize(text + line_start, text + sel_line_end).x;
+            end_x += ImGui::CalcTextSize(text, text + (sel_line_end - line_start)).x;
         }
         
         if (sel_line_end == line_end && line < end_line) {
@@ -273,8 +334,8 @@ void TextEditor::draw_cursor(float x, float y) {
     float cursor_width = font_size * 0.125f;
     float cursor_x = x - _scroll_x - cursor_offset;
     if (_cursor_pos > line_start) {
-        const char* text = buffer->get_text();
-        cursor_x += ImGui::CalcTextSize(text + line_start, text + _cursor_pos).x;
+        const char* text = fetch_range(line_start, _cursor_pos);
+        cursor_x += ImGui::CalcTextSize(text, text + (_cursor_pos - line_start)).x;
     }
     
     float line_h = get_line_height();
@@ -297,39 +358,32 @@ void TextEditor::handle_keyboard_input() {
     
     for (int i = 0; i < io.InputQueueCharacters.Size; ++i) {
         ImWchar c = io.InputQueueCharacters[i];
-        if (c >= 32 && c < 127) {
-            if (_selection_start != _selection_end) {
-                delete_range(std::min(_selection_start, _selection_end),
-                           std::max(_selection_start, _selection_end));
-            }
+        if (c >= 32 && c < 127 && begin_edit()) {
             char ch = static_cast<char>(c);
-            insert_text(&ch, 1);
+            replace_selection(&ch, 1);
             _blink_timer = 0.0f;
             _cursor_visible = true;
         }
     }
     
-    if (ImGui::IsKeyPressed(ImGuiKey_Enter) || ImGui::IsKeyPressed(ImGuiKey_KeypadEnter)) {
-        if (_selection_start != _selection_end) {
-            delete_range(std::min(_selection_start, _selection_end),
-                       std::max(_selection_start, _selection_end));
-        }
-        insert_text("\n", 1);
+    if ((ImGui::IsKeyPressed(ImGuiKey_Enter) || ImGui::IsKeyPressed(ImGuiKey_KeypadEnter)) && begin_edit()) {
+        replace_selection("\n", 1);
         _blink_timer = 0.0f;
         _cursor_visible = true;
     }
     
-    if (ImGui::IsKeyPressed(ImGuiKey_Tab)) {
-        if (_selection_start != _selection_end) {
-            delete_range(std::min(_selection_start, _selection_end),
-                       std::max(_selection_start, _selection_end));
+    if (ImGui::IsKeyPressed(ImGuiKey_Tab) && begin_edit()) {
+        TextBuffer* buffer = _document->get_buffer();
+        if (buffer->get_line_at_pos(_selection_start) != buffer->get_line_at_pos(_selection_end)) {
+            indent_selection();
+        } else {
+            replace_selection("    ", 4);
         }
-        insert_text("    ", 4);
         _blink_timer = 0.0f;
         _cursor_visible = true;
     }
     
-    if (ImGui::IsKeyPressed(ImGuiKey_Backspace)) {
+    if (ImGui::IsKeyPressed(ImGuiKey_Backspace) && begin_edit()) {
         if (_selection_start != _selection_end) {
             delete_range(std::min(_selection_start, _selection_end),
                        std::max(_selection_start, _selection_end));
@@ -340,7 +394,7 @@ void TextEditor::handle_keyboard_input() {
         _cursor_visible = true;
     }
     
-    if (ImGui::IsKeyPressed(ImGuiKey_Delete)) {
+    if (ImGui::IsKeyPressed(ImGuiKey_Delete) && begin_edit()) {
         if (_selection_start != _selection_end) {
             delete_range(std::min(_selection_start, _selection_end),
                        std::max(_selection_start, _selection_end));
@@ -397,17 +451,23 @@ void TextEditor::handle_keyboard_input() {
         copy_selection();
     }
     
-    if (ctrl && ImGui::IsKeyPressed(ImGuiKey_X)) {
+    if (ctrl && ImGui::IsKeyPressed(ImGuiKey_X) && begin_edit()) {
         cut_selection();
     }
     
-    if (ctrl && ImGui::IsKeyPressed(ImGuiKey_V)) {
+    if (ctrl && ImGui::IsKeyPressed(ImGuiKey_V) && begin_edit()) {
         paste();
     }
     
     if (ctrl && ImGui::IsKeyPressed(ImGuiKey_Z)) {
-        if (shift) redo();
-        else undo();
+        if (io.KeyAlt) {
+            if (shift) redo_across_files();
+            else undo_across_files();
+        } else if (shift) {
+            redo();
+        } else {
+            undo();
+        }
         _blink_timer = 0.0f;
         _cursor_visible = true;
     }
@@ -444,6 +504,7 @@ void TextEditor::handle_mouse_input() {
         ImVec2 mouse = io.MousePos;
         if (mouse.x > content_pos.x + gutter_w) {
             size_t pos = pos_from_coords(mouse.x - text_x + _scroll_x, mouse.y - text_y + _scroll_y);
+            _document->get_buffer()->seal_undo_group();
             _cursor_pos = pos;
             _selection_start = pos;
             _selection_end = pos;
@@ -479,11 +540,11 @@ size_t TextEditor::pos_from_coords(float x, float y) const {
     
     if (x <= 0) return line_start;
     
-    const char* text = buffer->get_text();
+    const char* text = fetch_range(line_start, line_end);
     
     for (size_t i = line_start; i < line_end; ++i) {
-        float width_to_char = ImGui::CalcTextSize(text + line_start, text + i + 1).x;
-        float width_before = (i > line_start) ? ImGui::CalcTextSize(text + line_start, text + i).x : 0.0f;
+        float width_to_char = ImGui::CalcTextSize(text, text + (i - line_start) + 1).x;
+        float width_before = (i > line_start) ? ImGui::CalcTextSize(text, text + (i - line_start)).x : 0.0f;
         float char_w = width_to_char - width_before;
         
         if (width_before + char_w * 0.5f > x) {
@@ -494,16 +555,20 @@ size_t TextEditor::pos_from_coords(float x, float y) const {
     return line_end;
 }
 
+bool TextEditor::begin_edit() {
+    if (!_document->get_buffer()->is_indexing()) {
+        return true;
+    }
+    _read_only_notice = READ_ONLY_NOTICE_SECONDS;
+    return false;
+}
+
 void TextEditor::insert_text(const char* text, size_t len) {
     if (!_document || len == 0) return;
     
     TextBuffer* buffer = _document->get_buffer();
-    size_t old_cursor = _cursor_pos;
-    
     buffer->insert(_cursor_pos, text, len, _cursor_pos);
     
-    UndoManager::instance().record_text_insert(_document->get_id(), _document->get_filepath(), _cursor_pos, text, len, old_cursor, _cursor_pos + len);
-    
     _cursor_pos += len;
     _selection_start = _cursor_pos;
     _selection_end = _cursor_pos;
@@ -515,12 +580,7 @@ void TextEditor::delete_range(size_t start, size_t end) {
     if (!_document || start >= end) return;
     
     TextBuffer* buffer = _document->get_buffer();
-    const char* text = buffer->get_text();
-    size_t len = end - start;
-    
-    UndoManager::instance().record_text_delete(_document->get_id(), _document->get_filepath(), start, text + start, len, _cursor_pos, start);
-    
-    buffer->remove(start, len, _cursor_pos);
+    buffer->remove(start, end - start, _cursor_pos);
     
     _cursor_pos = start;
     _selection_start = start;
@@ -529,6 +589,57 @@ void TextEditor::delete_range(size_t start, size_t end) {
     ensure_cursor_visible();
 }
 
+void TextEditor::replace_selection(const char* text, size_t len) {
+    if (!_document) return;
+    if (_selection_start == _selection_end) {
+        insert_text(text, len);
+        return;
+    }
+
+    TextBuffer* buffer = _document->get_buffer();
+    size_t start = std::min(_selection_start, _selection_end);
+    size_t end = std::max(_selection_start, _selection_end);
+
+    buffer->begin_batch();
+    buffer->batch_replace(start, end - start, text, len);
+    if (!buffer->commit(_cursor_pos, start + len)) return;
+
+    _cursor_pos = start + len;
+    _selection_start = _cursor_pos;
+    _selection_end = _cursor_pos;
+
+    ensure_cursor_visible();
+}
+
+void TextEditor::indent_selection() {
+    if (!_document) return;
+
+    TextBuffer* buffer = _document->get_buffer();
+    size_t start = std::min(_selection_start, _selection_end);
+    size_t end = std::max(_selection_start, _selection_end);
+    uint32_t first_line = buffer->get_line_at_pos(start);
+    uint32_t last_line = buffer->get_line_at_pos(end);
+    if (last_line > first_line && end == buffer->get_line_start(last_line)) {
+        --last_line;
+    }
+
+    buffer->begin_batch();
+    for (uint32_t line = first_line; line <= last_line; ++line) {
+        buffer->batch_replace(buffer->get_line_start(line), 0, "    ", 4);
+    }
+
+    size_t new_start = start + 4;
+    size_t new_end = end + 4 * (last_line - first_line + 1);
+    size_t new_cursor = _cursor_pos == end ? new_end : new_start;
+    if (!buffer->commit(_cursor_pos, new_cursor)) return;
+
+    _selection_start = _cursor_pos == end ? new_start : new_end;
+    _selection_end = new_cursor;
+    _cursor_pos = new_cursor;
+
+    ensure_cursor_visible();
+}
+
 void TextEditor::delete_char_before() {
     if (!_document || _cursor_pos == 0) return;
     delete_range(_cursor_pos - 1, _cursor_pos);
@@ -560,6 +671,10 @@ void TextEditor::move_cursor(int delta, bool select) {
 }
 
 void TextEditor::move_cursor_to(size_t pos, bool select) {
+    if (_document) {
+        _document->get_buffer()->seal_undo_group();
+    }
+
     if (!select && _selection_start != _selection_end) {
         _selection_start = pos;
         _selection_end = pos;
@@ -600,11 +715,10 @@ void TextEditor::move_word_left(bool select) {
     if (!_document || _cursor_pos == 0) return;
     
     TextBuffer* buffer = _document->get_buffer();
-    const char* text = buffer->get_text();
     size_t pos = _cursor_pos - 1;
     
-    while (pos > 0 && !is_word_char(text[pos])) --pos;
-    while (pos > 0 && is_word_char(text[pos - 1])) --pos;
+    while (pos > 0 && !is_word_char(buffer->char_at(pos))) --pos;
+    while (pos > 0 && is_word_char(buffer->char_at(pos - 1))) --pos;
     
     move_cursor_to(pos, select);
 }
@@ -613,12 +727,11 @@ void TextEditor::move_word_right(bool select) {
     if (!_document) return;
     
     TextBuffer* buffer = _document->get_buffer();
-    const char* text = buffer->get_text();
     size_t len = buffer->get_length();
     size_t pos = _cursor_pos;
     
-    while (pos < len && is_word_char(text[pos])) ++pos;
-    while (pos < len && !is_word_char(text[pos])) ++pos;
+    while (pos < len && is_word_char(buffer->char_at(pos))) ++pos;
+    while (pos < len && !is_word_char(buffer->char_at(pos))) ++pos;
     
     move_cursor_to(pos, select);
 }
@@ -659,14 +772,13 @@ void TextEditor::copy_selection() {
     if (!_document || _selection_start == _selection_end) return;
     
     TextBuffer* buffer = _document->get_buffer();
-    const char* text = buffer->get_text();
     
     size_t start = std::min(_selection_start, _selection_end);
     size_t end = std::max(_selection_start, _selection_end);
     size_t len = end - start;
     
     char* clipboard = new char[len + 1];
-    memcpy(clipboard, text + start, len);
+    buffer->copy_range(start, len, clipboard);
     clipboard[len] = '\0';
     
     ImGui::SetClipboardText(clipboard);
@@ -684,148 +796,90 @@ void TextEditor::paste() {
     const char* clipboard = ImGui::GetClipboardText();
     if (!clipboard || !_document) return;
     
-    if (_selection_start != _selection_end) {
-        delete_range(std::min(_selection_start, _selection_end),
-                   std::max(_selection_start, _selection_end));
-    }
-    
-    insert_text(clipboard, strlen(clipboard));
+    replace_selection(clipboard, strlen(clipboard));
 }
 
 void TextEditor::undo() {
+    if (!_document) return;
+
+    TextBuffer* buffer = _document->get_buffer();
+    if (!buffer->can_undo() || !begin_edit()) return;
+    set_cursor(buffer->undo());
+}
+
+void TextEditor::redo() {
+    if (!_document) return;
+
+    TextBuffer* buffer = _document->get_buffer();
+    if (!buffer->can_redo() || !begin_edit()) return;
+    set_cursor(buffer->redo());
+}
+
+void TextEditor::undo_across_files() {
     UndoManager& mgr = UndoManager::instance();
-    
-    while (true) {
-        const UndoAction* peek = mgr.peek_undo();
-        if (!peek) return;
-        
-        if (mgr.is_file_action(peek->type)) {
-            UndoAction* action = mgr.undo();
-            if (_file_ops) {
-                _file_ops->apply_undo(action);
-            }
-            return;
-        }
-        
-        Document* target_doc = nullptr;
-        if (_doc_manager) {
-            target_doc = _doc_manager->get_document(peek->doc_id);
-            if (!target_doc && peek->path) {
-                DocumentID new_id = _doc_manager->open_document(peek->path);
-                target_doc = _doc_manager->get_document(new_id);
-            }
-        } else if (_document && _document->get_id() == peek->doc_id) {
-            target_doc = _document;
+    const UndoAction* file_action = mgr.peek_undo();
+    uint64_t latest = file_action ? file_action->sequence : 0;
+    Document* target_doc = nullptr;
+
+    uint32_t count = _doc_manager ? _doc_manager->get_document_count() : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        Document* doc = _doc_manager->get_document_at(i);
+        uint64_t sequence = doc->get_buffer()->get_undo_sequence();
+        if (sequence > latest) {
+            latest = sequence;
+            target_doc = doc;
         }
-        
-        if (!target_doc) {
-            mgr.undo();
-            continue;
-        }
-        
-        if (_doc_manager && target_doc != _document) {
-            _doc_manager->set_active_document(target_doc->get_id());
-            _document = target_doc;
-            _cursor_pos = 0;
-            _selection_start = 0;
-            _selection_end = 0;
-            _scroll_x = 0.0f;
-            _scroll_y = 0.0f;
-        }
-        
-        UndoAction* action = mgr.undo();
-        if (!action) return;
-        
-        if (handle_text_undo(action)) return;
+    }
+
+    if (target_doc) {
+        activate_document(target_doc);
+        undo();
+    } else if (file_action && _file_ops) {
+        _file_ops->apply_undo(mgr.undo());
     }
 }
 
-void TextEditor::redo() {
+void TextEditor::redo_across_files() {
     UndoManager& mgr = UndoManager::instance();
-    
-    while (true) {
-        const UndoAction* peek = mgr.peek_redo();
-        if (!peek) return;
-        
-        if (mgr.is_file_action(peek->type)) {
-            UndoAction* action = mgr.redo();
-            if (_file_ops) {
-                _file_ops->apply_redo(action);
-            }
-            return;
-        }
-        
-        Document* target_doc = nullptr;
-        if (_doc_manager) {
-            target_doc = _doc_manager->get_document(peek->doc_id);
-            if (!target_doc && peek->path) {
-                DocumentID new_id = _doc_manager->open_document(peek->path);
-                target_doc = _doc_manager->get_document(new_id);
-            }
-        } else if (_document && _document->get_id() == peek->doc_id) {
-            target_doc = _document;
-        }
-        
-        if (!target_doc) {
-            mgr.redo();
-            continue;
-        }
-        
-        if (_doc_manager && target_doc != _document) {
-            _doc_manager->set_active_document(target_doc->get_id());
-            _document = target_doc;
-            _cursor_pos = 0;
-            _selection_start = 0;
-            _selection_end = 0;
-            _scroll_x = 0.0f;
-            _scroll_y = 0.0f;
+    const UndoAction* file_action = mgr.peek_redo();
+    uint64_t earliest = file_action ? file_action->sequence : UINT64_MAX;
+    Document* target_doc = nullptr;
+
+    uint32_t count = _doc_manager ? _doc_manager->get_document_count() : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        Document* doc = _doc_manager->get_document_at(i);
+        uint64_t sequence = doc->get_buffer()->get_redo_sequence();
+        if (sequence != 0 && sequence < earliest) {
+            earliest = sequence;
+            target_doc = doc;
         }
-        
-        UndoAction* action = mgr.redo();
-        if (!action) return;
-        
-        if (handle_text_redo(action)) return;
     }
-}
 
-bool TextEditor::handle_text_undo(UndoAction* action) {
-    if (!action || !_document) return false;
-    
-    TextBuffer* buffer = _document->get_buffer();
-    
-    if (action->type == UndoActionType::TextInsert) {
-        buffer->remove_no_history(action->pos, action->len);
-    } else if (action->type == UndoActionType::TextDelete) {
-        buffer->insert_no_history(action->pos, action->text, action->len);
-    } else {
-        return false;
+    if (target_doc) {
+        activate_document(target_doc);
+        redo();
+    } else if (file_action && _file_ops) {
+        _file_ops->apply_redo(mgr.redo());
     }
-    
-    _cursor_pos = action->cursor_before;
-    _selection_start = _cursor_pos;
-    _selection_end = _cursor_pos;
-    ensure_cursor_visible();
-    return true;
 }
 
-bool TextEditor::handle_text_redo(UndoAction* action) {
-    if (!action || !_document) return false;
-    
-    TextBuffer* buffer = _document->get_buffer();
-    
-    if (action->type == UndoActionType::TextInsert) {
-        buffer->insert_no_history(action->pos, action->text, action->len);
-    } else if (action->type == UndoActionType::TextDelete) {
-        buffer->remove_no_history(action->pos, action->len);
-    } else {
-        return false;
-    }
-    
-    _cursor_pos = action->cursor_after;
-    _selection_start = _cursor_pos;
-    _selection_end = _cursor_pos;
+void TextEditor::activate_document(Document* doc) {
+    if (doc == _document) return;
+
+    _doc_manager->set_active_document(doc->get_id());
+    _document = doc;
+    _cursor_pos = 0;
+    _selection_start = 0;
+    _selection_end = 0;
+    _scroll_x = 0.0f;
+    _scroll_y = 0.0f;
+}
+
+void TextEditor::set_cursor(size_t pos) {
+    _cursor_pos = pos;
+    _selection_start = pos;
+    _selection_end = pos;
     ensure_cursor_visible();
-    return true;
 }
 
 void TextEditor::ensure_cursor_visible() {
@@ -846,6 +900,24 @@ void TextEditor::ensure_cursor_visible() {
     if (_scroll_y < 0.0f) _scroll_y = 0.0f;
 }
 
+void TextEditor::go_to_line(uint32_t line) {
+    if (!_document) return;
+    
+    TextBuffer* buffer = _document->get_buffer();
+    uint32_t total_lines = buffer->get_line_count();
+    if (line >= total_lines) {
+        line = total_lines - 1;
+    }
+    
+    _cursor_pos = buffer->get_line_start(line);
+    _selection_start = _cursor_pos;
+    _selection_end = _cursor_pos;
+    _scroll_x = 0.0f;
+    _scroll_y = line * get_line_height() - _content_height * 0.5f;
+    if (_scroll_y < 0.0f) _scroll_y = 0.0f;
+    _focus_requested = true;
+}
+
 void TextEditor::get_cursor_coords(float& x, float& y) const {
     if (!_document) {
         x = 0.0f;
@@ -857,10 +929,10 @@ void TextEditor::get_cursor_coords(float& x, float& y) const {
     uint32_t line = buffer->get_line_at_pos(_cursor_pos);
     size_t line_start = buffer->get_line_start(line);
     
-    const char* text = buffer->get_text();
     x = 0.0f;
     if (_cursor_pos > line_start) {
-        x = ImGui::CalcTextSize(text + line_start, text + _cursor_pos).x;
+        const char* text = fetch_range(line_start, _cursor_pos);
+        x = ImGui::CalcTextSize(text, text + (_cursor_pos - line_start)).x;
     }
     y = line * get_line_height();
 }
@@ -0,0 +1,26 @@
+#include "lunaris/editor/text_snapshot.h"
+
+namespace lunaris {
+
+TextSnapshot::TextSnapshot(PieceNode* root, uint32_t version, bool line_index)
+    : _root(root)
+    , _version(version)
+    , _line_index(line_index)
+    , _refs(1) {
+}
+
+TextSnapshot::~TextSnapshot() {
+    PieceTree::release(_root);
+}
+
+void TextSnapshot::retain() {
+    _refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TextSnapshot::release() {
+    if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+}
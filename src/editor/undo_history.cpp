@@ -0,0 +1,341 @@
+#include "lunaris/editor/undo_history.h"
+#include "lunaris/editor/edit_batch.h"
+#include "lunaris/editor/undo_manager.h"
+#include "lunaris/editor/mapped_file.h"
+#include "lunaris/editor/piece_tree.h"
+#include "lunaris/core/settings.h"
+#include <chrono>
+#include <cstring>
+
+namespace lunaris {
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+UndoHistory::UndoHistory()
+    : _entries(nullptr)
+    , _first(0)
+    , _count(0)
+    , _cursor(0)
+    , _blocks(nullptr)
+    , _first_block(0)
+    , _next_block(0)
+    , _spare_block(nullptr)
+    , _log(nullptr)
+    , _base_index(0)
+    , _logged(0)
+    , _queued(0)
+    , _log_reset(true)
+    , _log_epoch(0)
+    , _bytes(0)
+    , _last_edit_ms(0)
+    , _sealed(true) {
+    _entries = new UndoEntry[MAX_ENTRIES];
+    _blocks = new UndoBlock[MAX_BLOCKS];
+}
+
+UndoHistory::~UndoHistory() {
+    clear();
+    delete[] _spare_block;
+    delete[] _blocks;
+    delete[] _entries;
+}
+
+size_t UndoHistory::batch_bytes(const EditBatch* batch) {
+    return sizeof(EditBatch) + batch->get_count() * sizeof(BatchEdit) + batch->get_text_size();
+}
+
+void UndoHistory::release_blocks_before(uint64_t seq) {
+    while (_first_block < seq) {
+        UndoBlock& block = block_at(_first_block);
+        _bytes -= block.capacity;
+        if (block.capacity == BLOCK_SIZE && !_spare_block) {
+            _spare_block = block.data;
+        } else {
+            delete[] block.data;
+        }
+        ++_first_block;
+    }
+}
+
+void UndoHistory::release_newest_block() {
+    --_next_block;
+    UndoBlock& block = block_at(_next_block);
+    _bytes -= block.capacity;
+    if (block.capacity == BLOCK_SIZE && !_spare_block) {
+        _spare_block = block.data;
+    } else {
+        delete[] block.data;
+    }
+}
+
+char* UndoHistory::allocate_text(UndoEntry& entry, size_t len) {
+    if (_first_block == _next_block || block_at(_next_block - 1).capacity - block_at(_next_block - 1).used < len) {
+        while (_next_block - _first_block >= MAX_BLOCKS && _count > 1) {
+            drop_oldest();
+        }
+        if (_next_block - _first_block >= MAX_BLOCKS) {
+            release_blocks_before(_next_block);
+        }
+
+        size_t capacity = len > BLOCK_SIZE ? len : BLOCK_SIZE;
+        UndoBlock& block = block_at(_next_block++);
+        if (capacity == BLOCK_SIZE && _spare_block) {
+            block.data = _spare_block;
+            _spare_block = nullptr;
+        } else {
+            block.data = new char[capacity];
+        }
+        block.capacity = capacity;
+        block.used = 0;
+        _bytes += capacity;
+    }
+
+    UndoBlock& block = block_at(_next_block - 1);
+    entry.block = _next_block - 1;
+    entry.text = block.data + block.used;
+    block.used += len;
+    return entry.text;
+}
+
+void UndoHistory::release_checkpoint(UndoEntry& entry) {
+    if (!entry.checkpoint) return;
+    PieceTree::release(entry.root_before);
+    PieceTree::release(entry.root_after);
+    entry.checkpoint = false;
+}
+
+void UndoHistory::release_entry(UndoEntry& entry) {
+    release_checkpoint(entry);
+    delete entry.batch;
+    entry.batch = nullptr;
+}
+
+void UndoHistory::drop_redo() {
+    if (_cursor == _count) return;
+    ++_log_epoch;
+
+    for (uint32_t i = _cursor; i < _count; ++i) {
+        UndoEntry& entry = entry_at(i);
+        if (entry.batch) {
+            _bytes -= batch_bytes(entry.batch);
+        }
+        release_entry(entry);
+    }
+
+    for (uint32_t i = _cursor; i < _count; ++i) {
+        UndoEntry& entry = entry_at(i);
+        if (!entry.text || entry.mapped) continue;
+        while (_next_block - 1 > entry.block) {
+            release_newest_block();
+        }
+        UndoBlock& block = block_at(entry.block);
+        block.used = entry.text - block.data;
+        break;
+    }
+    _count = _cursor;
+    if (_logged > _count) {
+        _logged = _count;
+    }
+    if (_queued > _count) {
+        _queued = _count;
+    }
+}
+
+void UndoHistory::drop_oldest() {
+    UndoEntry& entry = entry_at(0);
+    if (entry.batch) {
+        _bytes -= batch_bytes(entry.batch);
+    }
+    release_entry(entry);
+    _first = (_first + 1) % MAX_ENTRIES;
+    ++_base_index;
+    --_count;
+    if (_cursor > 0) --_cursor;
+    if (_logged > 0) --_logged;
+    if (_queued > 0) --_queued;
+
+    release_blocks_before(_count > 0 ? entry_at(0).block : _next_block);
+}
+
+void UndoHistory::enforce_budget() {
+    size_t budget = Settings::get()->get_undo_budget();
+    while (_bytes > budget && _count > 1) {
+        drop_oldest();
+    }
+}
+
+UndoEntry& UndoHistory::push(EditType type, size_t pos, size_t len, size_t cursor_before, size_t cursor_after) {
+    drop_redo();
+    if (_count >= MAX_ENTRIES) {
+        drop_oldest();
+    }
+
+    UndoEntry& entry = entry_at(_count++);
+    entry.type = type;
+    entry.mapped = false;
+    entry.checkpoint = false;
+    entry.block = _next_block > _first_block ? _next_block - 1 : _next_block;
+    entry.pos = pos;
+    entry.len = len;
+    entry.text = nullptr;
+    entry.cursor_before = cursor_before;
+    entry.cursor_after = cursor_after;
+    entry.batch = nullptr;
+    entry.root_before = nullptr;
+    entry.root_after = nullptr;
+    entry.sequence = UndoManager::instance().next_sequence();
+    _cursor = _count;
+    _sealed = false;
+    _last_edit_ms = now_ms();
+    return entry;
+}
+
+bool UndoHistory::try_extend(size_t pos, const char* text, size_t len) {
+    if (_sealed || len != 1 || _count == _queued || _cursor != _count) {
+        return false;
+    }
+
+    UndoEntry& last = entry_at(_count - 1);
+    if (last.type != EditType::Insert || last.pos + last.len != pos || last.len >= MAX_GROUP_LENGTH) {
+        return false;
+    }
+
+    char prev = last.text[last.len - 1];
+    if (prev == '\n' || (is_space(prev) && !is_space(text[0]))) {
+        return false;
+    }
+
+    UndoBlock& block = block_at(_next_block - 1);
+    if (last.block != _next_block - 1 || last.text + last.len != block.data + block.used || block.used >= block.capacity) {
+        return false;
+    }
+
+    int64_t now = now_ms();
+    if (now - _last_edit_ms > GROUP_PAUSE_MS) {
+        return false;
+    }
+
+    block.data[block.used++] = text[0];
+    ++last.len;
+    ++last.cursor_after;
+    _last_edit_ms = now;
+    return true;
+}
+
+void UndoHistory::record_insert(size_t pos, const char* text, size_t len, size_t cursor_before) {
+    if (try_extend(pos, text, len)) {
+        return;
+    }
+
+    UndoEntry& entry = push(EditType::Insert, pos, len, cursor_before, pos + len);
+    memcpy(allocate_text(entry, len), text, len);
+    enforce_budget();
+}
+
+char* UndoHistory::record_remove(size_t pos, size_t len, size_t cursor_before) {
+    UndoEntry& entry = push(EditType::Remove, pos, len, cursor_before, pos);
+    char* text = allocate_text(entry, len);
+    enforce_budget();
+    return text;
+}
+
+void UndoHistory::record_batch(EditBatch* batch, size_t cursor_before, size_t cursor_after) {
+    UndoEntry& entry = push(EditType::Batch, 0, 0, cursor_before, cursor_after);
+    entry.batch = batch;
+    _bytes += batch_bytes(batch);
+    enforce_budget();
+}
+
+void UndoHistory::attach_checkpoint(PieceNode* root_before, PieceNode* root_after) {
+    UndoEntry& entry = entry_at(_count - 1);
+    entry.checkpoint = true;
+    entry.root_before = root_before;
+    entry.root_after = root_after;
+}
+
+void UndoHistory::drop_checkpoints() {
+    for (uint32_t i = 0; i < _count; ++i) {
+        release_checkpoint(entry_at(i));
+    }
+}
+
+void UndoHistory::restore(MappedFile* log, const UndoEntry* entries, uint32_t count, uint32_t cursor, uint64_t base_index) {
+    clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        UndoEntry& entry = entry_at(i);
+        entry = entries[i];
+        entry.block = _next_block;
+        if (entry.batch) {
+            _bytes += batch_bytes(entry.batch);
+        }
+    }
+    _log = log;
+    _count = count;
+    _cursor = cursor;
+    _base_index = base_index;
+    _logged = count;
+    _queued = count;
+    _log_reset = false;
+    enforce_budget();
+}
+
+void UndoHistory::mark_queued() {
+    _queued = _count;
+    _log_reset = false;
+    _sealed = true;
+}
+
+void UndoHistory::mark_logged(uint64_t end_index, uint32_t epoch) {
+    if (epoch != _log_epoch || end_index <= _base_index + _logged) return;
+    _logged = static_cast<uint32_t>(end_index - _base_index);
+    if (_logged > _queued) {
+        _logged = _queued;
+    }
+}
+
+void UndoHistory::reset_log() {
+    _logged = 0;
+    _queued = 0;
+    _log_reset = true;
+    ++_log_epoch;
+}
+
+const UndoEntry* UndoHistory::undo() {
+    if (_cursor == 0) return nullptr;
+    _sealed = true;
+    return &entry_at(--_cursor);
+}
+
+const UndoEntry* UndoHistory::redo() {
+    if (_cursor == _count) return nullptr;
+    _sealed = true;
+    return &entry_at(_cursor++);
+}
+
+void UndoHistory::clear() {
+    for (uint32_t i = 0; i < _count; ++i) {
+        release_entry(entry_at(i));
+    }
+    release_blocks_before(_next_block);
+    delete _log;
+    _log = nullptr;
+    _first = 0;
+    _count = 0;
+    _cursor = 0;
+    _base_index = 0;
+    _logged = 0;
+    _queued = 0;
+    _log_reset = true;
+    ++_log_epoch;
+    _bytes = 0;
+    _sealed = true;
+}
+
+}
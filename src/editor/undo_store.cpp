@@ -0,0 +1,595 @@
+#include "lunaris/editor/undo_store.h"
+#include "lunaris/editor/undo_manager.h"
+#include "lunaris/editor/text_buffer.h"
+#include "lunaris/editor/edit_batch.h"
+#include "lunaris/editor/mapped_file.h"
+#include "lunaris/core/job_system.h"
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+
+namespace lunaris {
+
+static constexpr uint32_t LOG_MAGIC = 0x554E554C;
+static constexpr uint32_t LOG_VERSION = 1;
+
+enum class UndoRecordKind : uint8_t {
+    Entry = 1,
+    Checkpoint = 2
+};
+
+struct UndoLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t reserved;
+};
+
+struct UndoRecord {
+    UndoRecordKind kind;
+    EditType type;
+    uint16_t reserved;
+    uint32_t edit_count;
+    uint64_t index;
+    uint64_t pos;
+    uint64_t len;
+    uint64_t cursor_before;
+    uint64_t cursor_after;
+    uint64_t payload;
+};
+
+struct ContentHasher {
+    uint64_t state;
+    uint64_t tail;
+    uint32_t tail_bytes;
+    uint64_t length;
+};
+
+static void hash_word(ContentHasher& hasher, uint64_t word) {
+    hasher.state = (hasher.state ^ word) * 0x9E3779B97F4A7C15ull;
+    hasher.state ^= hasher.state >> 29;
+}
+
+static void hash_update(ContentHasher& hasher, const char* data, size_t len) {
+    hasher.length += len;
+    while (len > 0 && hasher.tail_bytes > 0) {
+        hasher.tail |= static_cast<uint64_t>(static_cast<uint8_t>(*data++)) << (hasher.tail_bytes * 8);
+        --len;
+        if (++hasher.tail_bytes == 8) {
+            hash_word(hasher, hasher.tail);
+            hasher.tail = 0;
+            hasher.tail_bytes = 0;
+        }
+    }
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        hash_word(hasher, word);
+        data += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        hasher.tail |= static_cast<uint64_t>(static_cast<uint8_t>(*data++)) << (hasher.tail_bytes * 8);
+        ++hasher.tail_bytes;
+        --len;
+    }
+}
+
+static uint64_t hash_finish(ContentHasher& hasher) {
+    hash_word(hasher, hasher.tail);
+    hash_word(hasher, hasher.length);
+    return hasher.state;
+}
+
+static uint64_t hash_text(TextIterator it) {
+    ContentHasher hasher = {0xCBF29CE484222325ull, 0, 0, 0};
+    TextSpan span;
+    while (it.next(span)) {
+        hash_update(hasher, span.data, span.length);
+    }
+    return hash_finish(hasher);
+}
+
+static size_t align_payload(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+static size_t entry_payload(const UndoEntry& entry) {
+    if (entry.type == EditType::Batch) {
+        return entry.batch->get_count() * sizeof(BatchEdit) + entry.batch->get_text_size();
+    }
+    return entry.len;
+}
+
+template<typename T>
+static void unlink_pending(T*& list, T* item) {
+    T** link = &list;
+    while (*link != item) {
+        link = &(*link)->next;
+    }
+    *link = item->next;
+}
+
+template<typename T, typename Free>
+static void release_pending(JobSystem* jobs, std::unique_lock<std::mutex>& lock, T*& list, Free free) {
+    while (list) {
+        T* item = list;
+        if (jobs && item->apply != INVALID_JOB_ID && !jobs->is_complete(item->apply)) {
+            JobID apply = item->apply;
+            lock.unlock();
+            jobs->wait(apply);
+            lock.lock();
+            continue;
+        }
+        list = item->next;
+        free(item);
+    }
+}
+
+UndoStore::UndoStore()
+    : _job_system(nullptr)
+    , _queue_head(0)
+    , _queue_count(0)
+    , _draining(false)
+    , _restores(nullptr)
+    , _commits(nullptr) {
+    _root[0] = '\0';
+    _directory[0] = '\0';
+}
+
+UndoStore::~UndoStore() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (UndoRestore* restore = _restores; restore; restore = restore->next) {
+        restore->buffer = nullptr;
+    }
+    for (UndoCommit* commit = _commits; commit; commit = commit->next) {
+        commit->buffer = nullptr;
+    }
+    _idle_cv.wait(lock, [this]() { return !_draining; });
+
+    release_pending(_job_system, lock, _restores, free_restore);
+    release_pending(_job_system, lock, _commits, [](UndoCommit* commit) { delete commit; });
+}
+
+void UndoStore::set_workspace(const char* root) {
+    if (!root || root[0] == '\0') {
+        _root[0] = '\0';
+        _directory[0] = '\0';
+        return;
+    }
+    if (strcmp(root, _root) == 0) {
+        return;
+    }
+
+    snprintf(_root, sizeof(_root), "%s", root);
+    snprintf(_directory, sizeof(_directory), "%s/.lunaris/undo", root);
+
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+    if (ec) {
+        _directory[0] = '\0';
+    }
+}
+
+void UndoStore::get_log_path(const char* filepath, char* out, size_t out_size) const {
+    ContentHasher hasher = {0xCBF29CE484222325ull, 0, 0, 0};
+    hash_update(hasher, filepath, strlen(filepath));
+    snprintf(out, out_size, "%s/%016llx.undo", _directory, static_cast<unsigned long long>(hash_finish(hasher)));
+}
+
+void UndoStore::save(const char* filepath, TextBuffer* buffer) {
+    if (!is_enabled() || buffer->get_length() >= TextBuffer::LARGE_FILE_THRESHOLD) {
+        return;
+    }
+
+    cancel_restore(buffer);
+
+    UndoHistory& history = buffer->get_history();
+    bool truncate = history.is_log_reset();
+    uint32_t first = history.get_queued();
+    uint32_t count = history.get_count();
+    uint64_t base = history.get_base_index();
+
+    size_t size = (truncate ? sizeof(UndoLogHeader) : 0) + sizeof(UndoRecord);
+    for (uint32_t i = first; i < count; ++i) {
+        size += sizeof(UndoRecord) + align_payload(entry_payload(history.get_entry(i)));
+    }
+
+    char* data = new char[size];
+    memset(data, 0, size);
+    char* out = data;
+    if (truncate) {
+        UndoLogHeader header = {LOG_MAGIC, LOG_VERSION, 0};
+        memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+    }
+
+    for (uint32_t i = first; i < count; ++i) {
+        const UndoEntry& entry = history.get_entry(i);
+        UndoRecord record = {};
+        record.kind = UndoRecordKind::Entry;
+        record.type = entry.type;
+        record.index = base + i;
+        record.pos = entry.pos;
+        record.len = entry.len;
+        record.cursor_before = entry.cursor_before;
+        record.cursor_after = entry.cursor_after;
+        record.payload = entry_payload(entry);
+
+        char* payload = out + sizeof(record);
+        if (entry.type == EditType::Batch) {
+            record.edit_count = entry.batch->get_count();
+            record.len = entry.batch->get_text_size();
+            size_t edits_size = record.edit_count * sizeof(BatchEdit);
+            memcpy(payload, entry.batch->get_edits(), edits_size);
+            memcpy(payload + edits_size, entry.batch->get_text(), record.len);
+        } else {
+            memcpy(payload, entry.text, entry.len);
+        }
+        memcpy(out, &record, sizeof(record));
+        out += sizeof(record) + align_payload(record.payload);
+    }
+
+    UndoRecord checkpoint = {};
+    checkpoint.kind = UndoRecordKind::Checkpoint;
+    checkpoint.index = base + count;
+    checkpoint.pos = base + history.get_cursor();
+    checkpoint.cursor_before = buffer->get_length();
+    memcpy(out, &checkpoint, sizeof(checkpoint));
+
+    history.mark_queued();
+
+    UndoCommit* commit = new UndoCommit();
+    commit->buffer = buffer;
+    commit->end_index = base + count;
+    commit->epoch = history.get_log_epoch();
+    commit->written = false;
+    commit->apply = INVALID_JOB_ID;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        commit->next = _commits;
+        _commits = commit;
+    }
+
+    char path[MAX_DIRECTORY_LENGTH + 32];
+    get_log_path(filepath, path, sizeof(path));
+    enqueue(path, data, size, buffer->snapshot(), nullptr, commit, truncate);
+}
+
+void UndoStore::save_as(const char* filepath, TextBuffer* buffer) {
+    buffer->get_history().reset_log();
+    save(filepath, buffer);
+}
+
+void UndoStore::restore(const char* filepath, TextBuffer* buffer) {
+    if (!is_enabled() || buffer->is_indexing() || buffer->get_length() >= TextBuffer::LARGE_FILE_THRESHOLD) {
+        return;
+    }
+
+    cancel_restore(buffer);
+
+    UndoRestore* restore = new UndoRestore();
+    restore->buffer = buffer;
+    restore->snapshot = buffer->snapshot();
+    restore->version = buffer->get_version();
+    restore->log = nullptr;
+    restore->entries = nullptr;
+    restore->count = 0;
+    restore->cursor = 0;
+    restore->base = 0;
+    restore->apply = INVALID_JOB_ID;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        restore->next = _restores;
+        _restores = restore;
+    }
+
+    char path[MAX_DIRECTORY_LENGTH + 32];
+    get_log_path(filepath, path, sizeof(path));
+    enqueue(path, nullptr, 0, nullptr, restore, nullptr, false);
+}
+
+void UndoStore::cancel_restore(TextBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (UndoRestore* restore = _restores; restore; restore = restore->next) {
+        if (restore->buffer == buffer) {
+            restore->buffer = nullptr;
+        }
+    }
+}
+
+void UndoStore::detach_buffer(TextBuffer* buffer) {
+    cancel_restore(buffer);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (UndoCommit* commit = _commits; commit; commit = commit->next) {
+        if (commit->buffer == buffer) {
+            commit->buffer = nullptr;
+        }
+    }
+}
+
+void UndoStore::apply_result(UndoRestore* restore, UndoCommit* commit) {
+    if (restore) {
+        apply_restore(restore);
+    } else {
+        apply_commit(commit);
+    }
+}
+
+void UndoStore::apply_commit(UndoCommit* commit) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        unlink_pending(_commits, commit);
+    }
+
+    if (commit->buffer) {
+        UndoHistory& history = commit->buffer->get_history();
+        if (commit->written) {
+            history.mark_logged(commit->end_index, commit->epoch);
+        } else {
+            history.reset_log();
+        }
+    }
+    delete commit;
+}
+
+void UndoStore::apply_restore(UndoRestore* restore) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        unlink_pending(_restores, restore);
+    }
+
+    TextBuffer* buffer = restore->buffer;
+    if (buffer && restore->log && buffer->get_version() == restore->version) {
+        for (uint32_t i = 0; i < restore->count; ++i) {
+            restore->entries[i].sequence = UndoManager::instance().next_sequence();
+        }
+        buffer->get_history().restore(restore->log, restore->entries, restore->count, restore->cursor, restore->base);
+        restore->log = nullptr;
+        restore->count = 0;
+    }
+    free_restore(restore);
+}
+
+void UndoStore::free_restore(UndoRestore* restore) {
+    if (restore->snapshot) {
+        restore->snapshot->release();
+    }
+    for (uint32_t i = 0; i < restore->count; ++i) {
+        delete restore->entries[i].batch;
+    }
+    delete[] restore->entries;
+    delete restore->log;
+    delete restore;
+}
+
+void UndoStore::read_log(const char* path, UndoRestore* restore) {
+    TextSnapshot* snapshot = restore->snapshot;
+    restore->snapshot = nullptr;
+
+    MappedFile* log = new MappedFile();
+    if (!log->open(path, true) || log->get_size() < sizeof(UndoLogHeader)) {
+        delete log;
+        snapshot->release();
+        return;
+    }
+
+    const char* data = log->get_data();
+    size_t size = log->get_size();
+    const UndoLogHeader* header = reinterpret_cast<const UndoLogHeader*>(data);
+    if (header->magic != LOG_MAGIC || header->version != LOG_VERSION) {
+        delete log;
+        snapshot->release();
+        return;
+    }
+
+    uint64_t* offsets = new uint64_t[64];
+    uint64_t capacity = 64;
+    uint64_t base = 0;
+    uint64_t count = 0;
+    bool started = false;
+    const UndoRecord* checkpoint = nullptr;
+    uint64_t checkpoint_count = 0;
+
+    size_t offset = sizeof(UndoLogHeader);
+    while (offset + sizeof(UndoRecord) <= size) {
+        const UndoRecord* record = reinterpret_cast<const UndoRecord*>(data + offset);
+        size_t next = offset + sizeof(UndoRecord) + align_payload(record->payload);
+        if (record->payload > size || next > size) {
+            break;
+        }
+
+        if (record->kind == UndoRecordKind::Entry) {
+            size_t expected = record->type == EditType::Batch
+                ? record->edit_count * sizeof(BatchEdit) + record->len : record->len;
+            if (expected != record->payload) {
+                break;
+            }
+            if (!started) {
+                base = record->index;
+                started = true;
+            }
+            if (record->index < base || record->index > base + count) {
+                break;
+            }
+            count = record->index - base;
+            if (count == capacity) {
+                uint64_t* grown = new uint64_t[capacity * 2];
+                memcpy(grown, offsets, capacity * sizeof(uint64_t));
+                delete[] offsets;
+                offsets = grown;
+                capacity *= 2;
+            }
+            offsets[count++] = offset;
+        } else if (record->kind == UndoRecordKind::Checkpoint) {
+            if (!started) {
+                base = record->index;
+                started = true;
+            }
+            if (record->index < base || record->index > base + count || record->pos < base || record->pos > record->index) {
+                break;
+            }
+            checkpoint = record;
+            checkpoint_count = record->index - base;
+        } else {
+            break;
+        }
+        offset = next;
+    }
+
+    bool valid = checkpoint && checkpoint->cursor_before == snapshot->get_length()
+        && checkpoint->len == hash_text(snapshot->get_view().get_range(0, snapshot->get_length()));
+    snapshot->release();
+    if (!valid) {
+        delete[] offsets;
+        delete log;
+        return;
+    }
+
+    uint64_t cursor = checkpoint->pos - base;
+    uint64_t skip = checkpoint_count > UndoHistory::MAX_ENTRIES ? checkpoint_count - UndoHistory::MAX_ENTRIES : 0;
+    if (skip > cursor) {
+        skip = cursor;
+    }
+    uint64_t end = skip + UndoHistory::MAX_ENTRIES < checkpoint_count ? skip + UndoHistory::MAX_ENTRIES : checkpoint_count;
+
+    uint32_t restored = static_cast<uint32_t>(end - skip);
+    UndoEntry* entries = new UndoEntry[restored > 0 ? restored : 1];
+    for (uint32_t i = 0; i < restored; ++i) {
+        const UndoRecord* record = reinterpret_cast<const UndoRecord*>(data + offsets[skip + i]);
+        const char* payload = reinterpret_cast<const char*>(record + 1);
+        UndoEntry& entry = entries[i];
+        entry.type = record->type;
+        entry.mapped = true;
+        entry.checkpoint = false;
+        entry.block = 0;
+        entry.pos = record->pos;
+        entry.len = record->type == EditType::Batch ? 0 : record->len;
+        entry.text = nullptr;
+        entry.cursor_before = record->cursor_before;
+        entry.cursor_after = record->cursor_after;
+        entry.batch = nullptr;
+        entry.root_before = nullptr;
+        entry.root_after = nullptr;
+        entry.sequence = 0;
+        if (record->type == EditType::Batch) {
+            size_t edits_size = record->edit_count * sizeof(BatchEdit);
+            entry.batch = new EditBatch();
+            entry.batch->assign(reinterpret_cast<const BatchEdit*>(payload), record->edit_count, payload + edits_size, record->len);
+        } else {
+            entry.text = const_cast<char*>(payload);
+        }
+    }
+
+    restore->log = log;
+    restore->entries = entries;
+    restore->count = restored;
+    restore->cursor = static_cast<uint32_t>(cursor - skip);
+    restore->base = base + skip;
+    delete[] offsets;
+}
+
+void UndoStore::enqueue(const char* path, char* data, size_t size, TextSnapshot* snapshot, UndoRestore* restore, UndoCommit* commit, bool truncate) {
+    UndoLogRequest request;
+    size_t path_len = strlen(path);
+    request.path = new char[path_len + 1];
+    memcpy(request.path, path, path_len + 1);
+    request.data = data;
+    request.size = size;
+    request.snapshot = snapshot;
+    request.restore = restore;
+    request.commit = commit;
+    request.truncate = truncate;
+
+    if (!_job_system) {
+        process(request);
+        delete[] request.path;
+        delete[] request.data;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle_cv.wait(lock, [this]() { return _queue_count < MAX_QUEUED_REQUESTS; });
+    _queue[(_queue_head + _queue_count) % MAX_QUEUED_REQUESTS] = request;
+    ++_queue_count;
+    if (_draining) {
+        return;
+    }
+    _draining = true;
+    lock.unlock();
+
+    JobID id = _job_system->submit_io([this]() {
+        drain();
+    }, "UndoLog", JobPriority::Low);
+    if (id == INVALID_JOB_ID) {
+        drain();
+    }
+}
+
+void UndoStore::drain() {
+    while (true) {
+        UndoLogRequest request;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_queue_count == 0) {
+                _draining = false;
+                _idle_cv.notify_all();
+                return;
+            }
+            request = _queue[_queue_head];
+            _queue_head = (_queue_head + 1) % MAX_QUEUED_REQUESTS;
+            --_queue_count;
+            _idle_cv.notify_all();
+        }
+
+        process(request);
+        delete[] request.path;
+        delete[] request.data;
+    }
+}
+
+void UndoStore::process(const UndoLogRequest& request) {
+    UndoRestore* restore = request.restore;
+    UndoCommit* commit = request.commit;
+    if (restore) {
+        read_log(request.path, restore);
+    } else {
+        commit->written = write_log(request);
+    }
+
+    JobID apply = INVALID_JOB_ID;
+    if (_job_system) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        apply = _job_system->post_to_main_thread([this, restore, commit]() {
+            apply_result(restore, commit);
+        }, "UndoLogResult");
+        if (restore) {
+            restore->apply = apply;
+        } else {
+            commit->apply = apply;
+        }
+    }
+    if (apply == INVALID_JOB_ID) {
+        apply_result(restore, commit);
+    }
+}
+
+void UndoStore::wait_idle() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle_cv.wait(lock, [this]() { return !_draining; });
+}
+
+bool UndoStore::write_log(const UndoLogRequest& request) {
+    UndoRecord* checkpoint = reinterpret_cast<UndoRecord*>(request.data + request.size - sizeof(UndoRecord));
+    checkpoint->len = hash_text(request.snapshot->get_view().get_range(0, request.snapshot->get_length()));
+    request.snapshot->release();
+
+    FILE* f = fopen(request.path, request.truncate ? "wb" : "ab");
+    if (!f) {
+        return false;
+    }
+    size_t written = fwrite(request.data, 1, request.size, f);
+    return fclose(f) == 0 && written == request.size;
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while (0)
@@ -0,0 +1,358 @@
+#include "check.h"
+#include "lunaris/core/job_system.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <string>
+
+using namespace lunaris;
+
+static void test_continuation_order(JobSystem& jobs) {
+    std::atomic<int> stage(0);
+    std::atomic<int> errors(0);
+
+    JobID first = jobs.submit_lambda([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        stage.store(1);
+    });
+    JobID second = jobs.then(first, [&]() {
+        if (stage.load() != 1) {
+            errors.fetch_add(1);
+        }
+        stage.store(2);
+    });
+    JobID third = jobs.then(second, [&]() {
+        if (stage.load() != 2) {
+            errors.fetch_add(1);
+        }
+        stage.store(3);
+    });
+
+    JobID fan[32];
+    std::atomic<int> fanned(0);
+    for (uint32_t i = 0; i < 32; ++i) {
+        fan[i] = jobs.then(third, [&]() {
+            if (stage.load() != 3) {
+                errors.fetch_add(1);
+            }
+            fanned.fetch_add(1);
+        });
+    }
+
+    std::atomic<bool> joined(false);
+    JobID join = jobs.submit_lambda_after(fan, 32, [&]() {
+        if (fanned.load() != 32) {
+            errors.fetch_add(1);
+        }
+        joined.store(true);
+    });
+    jobs.wait(join);
+    CHECK(joined.load());
+    CHECK(errors.load() == 0);
+
+    std::atomic<bool> late(false);
+    jobs.wait(jobs.then(first, [&]() { late.store(true); }));
+    CHECK(late.load());
+}
+
+static void test_chain_order(JobSystem& jobs) {
+    static constexpr int CHAIN_LENGTH = 2000;
+    std::atomic<int> next(0);
+    std::atomic<int> errors(0);
+    JobID previous = INVALID_JOB_ID;
+    for (int i = 0; i < CHAIN_LENGTH; ++i) {
+        previous = jobs.then(previous, [&next, &errors, i]() {
+            if (next.load() != i) {
+                errors.fetch_add(1);
+            }
+            next.fetch_add(1);
+        });
+    }
+    jobs.wait(previous);
+    CHECK(next.load() == CHAIN_LENGTH);
+    CHECK(errors.load() == 0);
+}
+
+static void test_when_all(JobSystem& jobs) {
+    std::atomic<int> done(0);
+    JobID ids[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        ids[i] = jobs.submit_lambda([&]() { done.fetch_add(1); });
+    }
+    jobs.wait(jobs.when_all(ids, 8));
+    CHECK(done.load() == 8);
+}
+
+static void test_wait_on_main_thread(JobSystem& jobs) {
+    std::thread::id main_id = std::this_thread::get_id();
+    std::atomic<int> stage(0);
+    std::atomic<bool> on_main(false);
+
+    JobID worker = jobs.submit_lambda([&]() { stage.store(1); });
+    JobID main = jobs.then_on_main_thread(worker, [&]() {
+        on_main.store(std::this_thread::get_id() == main_id);
+        stage.store(2);
+    });
+    JobID after = jobs.then(main, [&]() {
+        if (stage.load() == 2) {
+            stage.store(3);
+        }
+    });
+
+    jobs.wait(after);
+    CHECK(on_main.load());
+    CHECK(stage.load() == 3);
+
+    std::atomic<bool> posted(false);
+    jobs.wait(jobs.post_to_main_thread([&]() { posted.store(true); }));
+    CHECK(posted.load());
+
+    std::atomic<bool> unrelated(false);
+    jobs.post_to_main_thread([&]() { unrelated.store(true); });
+    JobID slow = jobs.submit_lambda([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    jobs.wait(slow);
+    CHECK(!unrelated.load());
+
+    std::atomic<int> chained(0);
+    JobID first = jobs.submit_lambda([&]() { chained.fetch_add(1); });
+    JobID middle = jobs.then_on_main_thread(first, [&]() { chained.fetch_add(1); });
+    jobs.then(middle, [&]() { chained.fetch_add(1); });
+    jobs.wait_all();
+    CHECK(chained.load() == 3);
+    CHECK(!unrelated.load());
+    while (jobs.drain_main_thread(1000.0f) > 0) {
+    }
+    CHECK(unrelated.load());
+}
+
+static void test_delayed_rollover(JobSystem& jobs) {
+    static constexpr uint32_t COUNT = 9;
+    static const uint32_t delays[COUNT] = { 700, 1, 255, 256, 257, 300, 512, 513, 100 };
+    std::atomic<int64_t> fired[COUNT];
+    JobID ids[COUNT];
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        fired[i].store(-1);
+        ids[i] = jobs.submit_delayed(delays[i], [&fired, &start, i]() {
+            fired[i].store(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+        });
+        CHECK(ids[i] != INVALID_JOB_ID);
+    }
+    jobs.wait(jobs.when_all(ids, COUNT));
+
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        CHECK(fired[i].load() >= delays[i]);
+        CHECK(fired[i].load() < delays[i] + 250);
+        for (uint32_t k = 0; k < COUNT; ++k) {
+            if (delays[k] + 20 < delays[i]) {
+                CHECK(fired[k].load() <= fired[i].load());
+            }
+        }
+    }
+}
+
+static void test_wait_all_skips_timers(JobSystem& jobs) {
+    static CancelSource parked;
+    JobID poll = jobs.submit_delayed(60000, []() {}, "Parked", JobPriority::Normal, JobTarget::Worker, parked.get_token());
+    CHECK(poll != INVALID_JOB_ID);
+
+    std::atomic<int> nested(0);
+    jobs.submit_lambda([&]() {
+        jobs.submit_lambda([&]() { nested.fetch_add(1); });
+        jobs.wait_all();
+        nested.fetch_add(1);
+    });
+    jobs.wait_all();
+    CHECK(nested.load() == 2);
+    CHECK(!jobs.is_complete(poll));
+    parked.cancel();
+}
+
+static void test_debounce_throttle(JobSystem& jobs) {
+    CancelSource key;
+    std::atomic<int> last(0);
+    std::atomic<int> runs(0);
+    JobID debounced[5];
+    for (int i = 0; i < 5; ++i) {
+        debounced[i] = jobs.debounce(key, 300, [&last, &runs, i]() {
+            last.store(i + 1);
+            runs.fetch_add(1);
+        });
+    }
+    for (int i = 0; i < 5; ++i) {
+        jobs.wait(debounced[i]);
+    }
+    CHECK(runs.load() == 1);
+    CHECK(last.load() == 5);
+
+    Throttle throttle;
+    std::atomic<int> throttled(0);
+    JobID throttled_ids[5];
+    throttled_ids[0] = jobs.throttle(throttle, 300, [&]() { throttled.fetch_add(1); });
+    for (int i = 1; i < 5; ++i) {
+        throttled_ids[i] = jobs.throttle(throttle, 300, [&]() { throttled.fetch_add(10); });
+    }
+    for (int i = 0; i < 5; ++i) {
+        jobs.wait(throttled_ids[i]);
+    }
+    CHECK(throttled.load() == 11);
+}
+
+static void run_batch(JobSystem& jobs, uint32_t count) {
+    JobID ids[64];
+    for (uint32_t i = 0; i < count; ++i) {
+        ids[i] = jobs.submit_lambda([]() {}, "ProfiledJob");
+    }
+    jobs.wait(jobs.when_all(ids, count));
+}
+
+static uint32_t count_occurrences(const std::string& path, const char* needle) {
+    std::string text;
+    FILE* f = fopen(path.c_str(), "rb");
+    CHECK(f);
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(f);
+
+    uint32_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+static void test_profiling_sessions(JobSystem& jobs) {
+    std::string path = (std::filesystem::temp_directory_path() / "lunaris_job_trace.json").string();
+    uint32_t event_count = 0;
+
+    jobs.set_profiling(true);
+    std::atomic<bool> stop(false);
+    std::thread producer([&]() {
+        while (!stop.load()) {
+            run_batch(jobs, 64);
+        }
+    });
+    for (uint32_t i = 0; i < 50; ++i) {
+        jobs.set_profiling(false);
+        jobs.set_profiling(true);
+        CHECK(jobs.export_chrome_trace(path.c_str(), event_count));
+    }
+    stop.store(true);
+    producer.join();
+    jobs.wait_all();
+
+    jobs.set_profiling(false);
+    jobs.set_profiling(true);
+    run_batch(jobs, 10);
+    jobs.set_profiling(false);
+    CHECK(jobs.export_chrome_trace(path.c_str(), event_count));
+    CHECK(count_occurrences(path, "{\"name\":\"ProfiledJob\"") == 10);
+    std::filesystem::remove(path);
+}
+
+static void test_profile_nested(JobSystem& jobs) {
+    static constexpr uint32_t COUNT = 12;
+    jobs.set_profiling(true);
+    JobID outer = jobs.submit_lambda([&]() {
+        JobID inner[COUNT];
+        for (uint32_t i = 0; i < COUNT; ++i) {
+            inner[i] = jobs.submit_lambda([]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            });
+        }
+        jobs.wait(jobs.when_all(inner, COUNT));
+    });
+    jobs.wait(outer);
+    JobProfile profile = jobs.get_profile();
+    jobs.set_profiling(false);
+
+    for (uint32_t i = 0; i < JobSystem::MAX_LANES; ++i) {
+        CHECK(profile.lanes[i].busy_ns <= profile.elapsed_ns);
+    }
+}
+
+struct RangeSpan {
+    RangeSpan(size_t first, size_t last) : first(first), last(last) {}
+
+    size_t first;
+    size_t last;
+};
+
+static void test_reduce_sum(JobSystem& jobs) {
+    static constexpr size_t COUNT = 1000000;
+    uint64_t sum = jobs.parallel_reduce(0, COUNT, 1024, static_cast<uint64_t>(0), [](size_t begin, size_t end) {
+        uint64_t partial = 0;
+        for (size_t i = begin; i < end; ++i) {
+            partial += i;
+        }
+        return partial;
+    }, [](uint64_t a, uint64_t b) {
+        return a + b;
+    });
+    CHECK(sum == static_cast<uint64_t>(COUNT) * (COUNT - 1) / 2);
+
+    uint64_t empty = jobs.parallel_reduce(5, 5, 1, static_cast<uint64_t>(7), [](size_t, size_t) {
+        return static_cast<uint64_t>(1);
+    }, [](uint64_t a, uint64_t b) {
+        return a + b;
+    });
+    CHECK(empty == 7);
+}
+
+static void test_reduce_order(JobSystem& jobs) {
+    static constexpr size_t COUNT = 4096;
+    RangeSpan identity(SIZE_MAX, SIZE_MAX);
+    RangeSpan span = jobs.parallel_reduce(0, COUNT, 16, identity, [](size_t begin, size_t end) {
+        return RangeSpan(begin, end);
+    }, [](const RangeSpan& a, const RangeSpan& b) {
+        if (a.first == SIZE_MAX) {
+            return b;
+        }
+        if (b.first == SIZE_MAX) {
+            return a;
+        }
+        return RangeSpan(a.last == b.first ? a.first : SIZE_MAX - 1, b.last);
+    });
+    CHECK(span.first == 0);
+    CHECK(span.last == COUNT);
+
+    std::string digits = jobs.parallel_reduce(0, 64, 1, std::string(), [](size_t begin, size_t end) {
+        std::string text;
+        for (size_t i = begin; i < end; ++i) {
+            text.push_back(static_cast<char>('0' + i % 10));
+        }
+        return text;
+    }, [](const std::string& a, const std::string& b) {
+        return a + b;
+    });
+    std::string expected;
+    for (size_t i = 0; i < 64; ++i) {
+        expected.push_back(static_cast<char>('0' + i % 10));
+    }
+    CHECK(digits == expected);
+}
+
+int main() {
+    JobSystem jobs;
+    jobs.init(3);
+    test_continuation_order(jobs);
+    test_chain_order(jobs);
+    test_when_all(jobs);
+    test_wait_on_main_thread(jobs);
+    test_delayed_rollover(jobs);
+    test_wait_all_skips_timers(jobs);
+    test_debounce_throttle(jobs);
+    test_profiling_sessions(jobs);
+    test_profile_nested(jobs);
+    test_reduce_sum(jobs);
+    test_reduce_order(jobs);
+    jobs.shutdown();
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "check.h"
+#include "lunaris/core/task.h"
+#include "lunaris/core/async_file.h"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+using namespace lunaris;
+
+struct TaskState {
+    JobSystem* jobs;
+    std::thread::id main_id;
+    std::atomic<int> stage;
+    std::atomic<int> errors;
+    std::atomic<bool> done;
+};
+
+static void expect(TaskState* state, bool condition) {
+    if (!condition) {
+        state->errors.fetch_add(1);
+    }
+}
+
+static void run_until_done(TaskState* state) {
+    while (!state->done.load()) {
+        state->jobs->drain_main_thread(1.0f);
+        std::this_thread::yield();
+    }
+}
+
+static Task step(TaskState* state, int from, int to) {
+    co_await ResumeOn(state->jobs, JobTarget::Worker);
+    expect(state, std::this_thread::get_id() != state->main_id);
+    expect(state, state->stage.load() == from);
+    state->stage.store(to);
+}
+
+static Task chain(TaskState* state) {
+    co_await step(state, 0, 1);
+    co_await step(state, 1, 2);
+
+    JobID id = state->jobs->submit_lambda([state]() {
+        state->stage.store(3);
+    });
+    co_await JobAwaiter(state->jobs, id, JobTarget::MainThread);
+    expect(state, std::this_thread::get_id() == state->main_id);
+    expect(state, state->stage.load() == 3);
+    state->done.store(true);
+}
+
+static void test_chain(JobSystem& jobs) {
+    TaskState state;
+    state.jobs = &jobs;
+    state.main_id = std::this_thread::get_id();
+    state.stage.store(0);
+    state.errors.store(0);
+    state.done.store(false);
+
+    chain(&state).start();
+    run_until_done(&state);
+    CHECK(state.stage.load() == 3);
+    CHECK(state.errors.load() == 0);
+}
+
+static Task round_trip(TaskState* state, const char* path) {
+    const char* text = "written by a task\n";
+    bool ok = co_await write_file_async(state->jobs, path, text, strlen(text));
+    expect(state, ok);
+
+    FileReadResult result = co_await read_file_async(state->jobs, path, JobTarget::MainThread);
+    expect(state, std::this_thread::get_id() == state->main_id);
+    expect(state, result.data && result.length == strlen(text) && memcmp(result.data, text, result.length) == 0);
+    delete[] result.data;
+    state->done.store(true);
+}
+
+static void test_file_round_trip(JobSystem& jobs, const std::filesystem::path& root) {
+    TaskState state;
+    state.jobs = &jobs;
+    state.main_id = std::this_thread::get_id();
+    state.errors.store(0);
+    state.done.store(false);
+
+    std::string path = (root / "round_trip.txt").string();
+    round_trip(&state, path.c_str()).start();
+    run_until_done(&state);
+    CHECK(state.errors.load() == 0);
+}
+
+static Task overflow(TaskState* state, const char* path) {
+    bool ok = co_await write_file_async(state->jobs, path, "x", 1);
+    expect(state, !ok);
+
+    FileReadResult result = co_await read_file_async(state->jobs, path);
+    expect(state, !result.data && result.length == 0);
+    state->done.store(true);
+}
+
+static void test_path_overflow(JobSystem& jobs, const std::filesystem::path& root) {
+    TaskState state;
+    state.jobs = &jobs;
+    state.main_id = std::this_thread::get_id();
+    state.errors.store(0);
+    state.done.store(false);
+
+    std::string path = root.string() + "/" + std::string(FileReadAwaiter::MAX_PATH_LEN, 'a');
+    overflow(&state, path.c_str()).start();
+    CHECK(state.done.load());
+    CHECK(state.errors.load() == 0);
+}
+
+int main() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "lunaris_task_test";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    JobSystem jobs;
+    jobs.init(2);
+    test_chain(jobs);
+    test_file_round_trip(jobs, root);
+    test_path_overflow(jobs, root);
+    jobs.shutdown();
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
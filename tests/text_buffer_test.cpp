@@ -0,0 +1,98 @@
+#include "check.h"
+#include "lunaris/editor/text_buffer.h"
+#include <filesystem>
+#include <string>
+
+using namespace lunaris;
+
+static std::string read_text(const TextBuffer& buffer) {
+    std::string text;
+    TextIterator it = buffer.get_range(0, buffer.get_length());
+    TextSpan span;
+    while (it.next(span)) {
+        text.append(span.data, span.length);
+    }
+    return text;
+}
+
+static uint32_t count_lines(const std::string& text) {
+    uint32_t lines = 1;
+    for (char c : text) {
+        lines += c == '\n';
+    }
+    return lines;
+}
+
+static void test_detach_truncated_mapping(const std::filesystem::path& root) {
+    std::string path = (root / "mapped.txt").string();
+    std::string content;
+    while (content.size() <= TextBuffer::MMAP_THRESHOLD) {
+        content += "line of mapped text\n";
+    }
+    FILE* f = fopen(path.c_str(), "wb");
+    CHECK(f);
+    fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(path.c_str()));
+    CHECK(buffer.is_mapped());
+
+    size_t keep = content.size() / 2 + 7;
+    buffer.insert(100, "head\n", 5, 100);
+    buffer.insert(keep - 1000, "middle\n", 7, keep - 1000);
+    buffer.insert(buffer.get_length() - 50, "tail\n", 5, buffer.get_length() - 50);
+
+    std::filesystem::resize_file(path, keep);
+    CHECK(buffer.check_backing_file(path.c_str()) == FileChange::Modified);
+    CHECK(buffer.detach_backing_file());
+    CHECK(!buffer.is_mapped());
+    CHECK(buffer.is_modified());
+    CHECK(!buffer.can_undo());
+
+    std::string expected = content.substr(0, keep);
+    expected.insert(100, "head\n");
+    expected.insert(keep - 1000, "middle\n");
+    expected += "tail\n";
+    std::string text = read_text(buffer);
+    CHECK(text == expected);
+    CHECK(buffer.get_line_count() == count_lines(expected));
+}
+
+static void test_read_after_external_truncate(const std::filesystem::path& root) {
+    std::string path = (root / "shrunk.txt").string();
+    std::string content;
+    while (content.size() <= TextBuffer::MMAP_THRESHOLD) {
+        content += "mapped line that will vanish\n";
+    }
+    FILE* f = fopen(path.c_str(), "wb");
+    CHECK(f);
+    fwrite(content.data(), 1, content.size(), f);
+    fclose(f);
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(path.c_str()));
+    CHECK(buffer.is_mapped());
+
+    size_t keep = 10000;
+    std::filesystem::resize_file(path, keep);
+    std::string text = read_text(buffer);
+    CHECK(text.size() == content.size());
+    CHECK(text.compare(0, keep, content, 0, keep) == 0);
+
+    CHECK(buffer.check_backing_file(path.c_str()) == FileChange::Modified);
+    CHECK(buffer.detach_backing_file());
+    CHECK(read_text(buffer) == content.substr(0, keep));
+}
+
+int main() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "lunaris_text_buffer_test";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    test_detach_truncated_mapping(root);
+    test_read_after_external_truncate(root);
+
+    std::filesystem::remove_all(root);
+    return 0;
+}
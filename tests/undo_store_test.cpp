@@ -0,0 +1,214 @@
+#include "check.h"
+#include "lunaris/editor/undo_store.h"
+#include "lunaris/editor/text_buffer.h"
+#include "lunaris/core/job_system.h"
+#include <filesystem>
+#include <string>
+
+using namespace lunaris;
+
+static std::string read_text(const TextBuffer& buffer) {
+    std::string text;
+    TextIterator it = buffer.get_range(0, buffer.get_length());
+    TextSpan span;
+    while (it.next(span)) {
+        text.append(span.data, span.length);
+    }
+    return text;
+}
+
+static std::string write_file(const std::filesystem::path& path, const char* text) {
+    FILE* f = fopen(path.string().c_str(), "wb");
+    CHECK(f);
+    fputs(text, f);
+    fclose(f);
+    return path.string();
+}
+
+static void finish_restore(UndoStore& store, JobSystem& jobs) {
+    store.wait_idle();
+    while (jobs.drain_main_thread(1000.0f) > 0) {
+    }
+}
+
+static void test_save_restore(JobSystem& jobs, const std::filesystem::path& root) {
+    std::string path = write_file(root / "a.txt", "hello\nworld\n");
+
+    UndoStore store;
+    store.set_job_system(&jobs);
+    store.set_workspace(root.string().c_str());
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(path.c_str()));
+    buffer.insert(0, "one ", 4, 0);
+    buffer.insert(4, "two ", 4, 4);
+    buffer.remove(0, 4, 8);
+    CHECK(buffer.save_to_file(path.c_str()));
+    store.save(path.c_str(), &buffer);
+    store.wait_idle();
+
+    TextBuffer restored;
+    CHECK(restored.load_from_file(path.c_str()));
+    store.restore(path.c_str(), &restored);
+    finish_restore(store, jobs);
+    CHECK(read_text(restored) == "two hello\nworld\n");
+    CHECK(restored.can_undo());
+    restored.undo();
+    CHECK(read_text(restored) == "one two hello\nworld\n");
+    CHECK(restored.can_undo());
+    restored.undo();
+    CHECK(restored.can_undo());
+    restored.undo();
+    CHECK(read_text(restored) == "hello\nworld\n");
+    CHECK(!restored.can_undo());
+}
+
+static void test_save_as_restore(JobSystem& jobs, const std::filesystem::path& root) {
+    std::string first = write_file(root / "b.txt", "alpha\n");
+    std::string second = (root / "c.txt").string();
+
+    UndoStore store;
+    store.set_job_system(&jobs);
+    store.set_workspace(root.string().c_str());
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(first.c_str()));
+    buffer.insert(6, "beta\n", 5, 6);
+    CHECK(buffer.save_to_file(first.c_str()));
+    store.save(first.c_str(), &buffer);
+
+    CHECK(buffer.save_to_file(second.c_str()));
+    store.save_as(second.c_str(), &buffer);
+    buffer.insert(11, "gamma\n", 6, 11);
+    CHECK(buffer.save_to_file(second.c_str()));
+    store.save(second.c_str(), &buffer);
+    store.wait_idle();
+
+    TextBuffer restored;
+    CHECK(restored.load_from_file(second.c_str()));
+    store.restore(second.c_str(), &restored);
+    finish_restore(store, jobs);
+    CHECK(read_text(restored) == "alpha\nbeta\ngamma\n");
+    CHECK(restored.can_undo());
+    restored.undo();
+    CHECK(read_text(restored) == "alpha\nbeta\n");
+    CHECK(restored.can_undo());
+    restored.undo();
+    CHECK(read_text(restored) == "alpha\n");
+    CHECK(!restored.can_undo());
+}
+
+static void test_stale_restore(JobSystem& jobs, const std::filesystem::path& root) {
+    std::string path = write_file(root / "d.txt", "delta\n");
+
+    UndoStore store;
+    store.set_job_system(&jobs);
+    store.set_workspace(root.string().c_str());
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(path.c_str()));
+    buffer.insert(0, "x", 1, 0);
+    CHECK(buffer.save_to_file(path.c_str()));
+    store.save(path.c_str(), &buffer);
+    store.wait_idle();
+
+    TextBuffer edited;
+    CHECK(edited.load_from_file(path.c_str()));
+    store.restore(path.c_str(), &edited);
+    edited.insert(0, "y", 1, 0);
+    finish_restore(store, jobs);
+    CHECK(edited.can_undo());
+    edited.undo();
+    CHECK(!edited.can_undo());
+
+    TextBuffer closed;
+    CHECK(closed.load_from_file(path.c_str()));
+    store.restore(path.c_str(), &closed);
+    store.detach_buffer(&closed);
+    finish_restore(store, jobs);
+    CHECK(!closed.can_undo());
+
+    TextBuffer pending[3];
+    {
+        UndoStore other;
+        other.set_job_system(&jobs);
+        other.set_workspace(root.string().c_str());
+        for (uint32_t i = 0; i < 3; ++i) {
+            CHECK(pending[i].load_from_file(path.c_str()));
+            other.restore(path.c_str(), &pending[i]);
+        }
+        other.wait_idle();
+    }
+    for (uint32_t i = 0; i < 3; ++i) {
+        CHECK(!pending[i].can_undo());
+    }
+    CHECK(jobs.drain_main_thread(1000.0f) == 0);
+}
+
+static void test_failed_write(JobSystem& jobs, const std::filesystem::path& root) {
+    std::filesystem::path workspace = root / "failed";
+    std::filesystem::create_directories(workspace);
+    std::string path = write_file(workspace / "e.txt", "echo\n");
+
+    UndoStore store;
+    store.set_job_system(&jobs);
+    store.set_workspace(workspace.string().c_str());
+
+    TextBuffer buffer;
+    CHECK(buffer.load_from_file(path.c_str()));
+    buffer.insert(0, "a", 1, 0);
+    CHECK(buffer.save_to_file(path.c_str()));
+    store.save(path.c_str(), &buffer);
+    finish_restore(store, jobs);
+    CHECK(buffer.get_history().get_logged() == 1);
+
+    std::filesystem::path log;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(workspace / ".lunaris" / "undo")) {
+        log = entry.path();
+    }
+    std::filesystem::remove(log);
+    std::filesystem::create_directory(log);
+
+    buffer.insert(1, "b", 1, 1);
+    buffer.seal_undo_group();
+    CHECK(buffer.save_to_file(path.c_str()));
+    store.save(path.c_str(), &buffer);
+    finish_restore(store, jobs);
+    CHECK(buffer.get_history().get_logged() == 0);
+    CHECK(buffer.get_history().is_log_reset());
+
+    std::filesystem::remove(log);
+    buffer.insert(2, "c", 1, 2);
+    CHECK(buffer.save_to_file(path.c_str()));
+    store.save(path.c_str(), &buffer);
+    finish_restore(store, jobs);
+    CHECK(buffer.get_history().get_logged() == 3);
+
+    TextBuffer restored;
+    CHECK(restored.load_from_file(path.c_str()));
+    store.restore(path.c_str(), &restored);
+    finish_restore(store, jobs);
+    CHECK(read_text(restored) == "abcecho\n");
+    restored.undo();
+    restored.undo();
+    restored.undo();
+    CHECK(read_text(restored) == "echo\n");
+    CHECK(!restored.can_undo());
+}
+
+int main() {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "lunaris_undo_store_test";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    JobSystem jobs;
+    jobs.init(2);
+    test_save_restore(jobs, root);
+    test_save_as_restore(jobs, root);
+    test_stale_restore(jobs, root);
+    test_failed_write(jobs, root);
+    jobs.shutdown();
+
+    std::filesystem::remove_all(root);
+    return 0;
+}